@@ -0,0 +1,24 @@
+#ifndef AOT_H
+#define AOT_H
+
+#include <stdint.h>
+#include "chip8.h"
+
+/*
+    Ahead-of-time translated ROM (make aot ROM=...).
+    These are implemented by the C translation unit that chip8-aot generates
+    for one specific ROM, and are only linked into CHIP8_AOT builds.
+*/
+
+/*
+    Runs the translated block starting at chip8->pc if there is one, it fits
+    in the remaining cycle budget and its code has not been modified.
+    Returns the number of instructions executed, or 0 if the caller should
+    interpret one instruction instead.
+*/
+uint32_t chip8_aot_run_block(chip8_t* chip8, uint32_t budget);
+
+// Flags the instance if a store changed any byte of translated code
+void chip8_aot_check_write(chip8_t* chip8, uint16_t address, uint16_t length);
+
+#endif // AOT_H
@@ -0,0 +1,58 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+    Buzzer audio. The emulation thread renders the square wave for each
+    emulated 60 Hz frame (audio_tone_render) and queues it in an
+    audio_ring_t, a lock-free single-producer single-consumer ring that the
+    platform's audio callback drains. Samples are signed 16-bit mono.
+*/
+
+#define AUDIO_SAMPLE_RATE 48000
+#define AUDIO_TONE_HZ 440
+#define AUDIO_AMPLITUDE 3000
+#define AUDIO_DEFAULT_BUFFER 128   // device buffer in samples, 2.7 ms at 48 kHz
+#define AUDIO_MAX_FRAME_SAMPLES 4096 // one 60 Hz frame at up to 192 kHz, plus rate correction
+
+typedef struct {
+    int16_t* samples;
+    uint32_t mask;                            // capacity - 1, capacity is a power of two
+    _Alignas(64) atomic_uint head;            // next write, advanced by the producer
+    _Alignas(64) atomic_uint tail;            // next read, advanced by the consumer
+    atomic_uint_fast64_t underruns;           // reads that came up short, counted by the consumer
+} audio_ring_t;
+
+// Capacity is rounded up to a power of two. Returns NULL (and reports why) on failure.
+audio_ring_t* audio_ring_create(uint32_t capacity);
+void audio_ring_destroy(audio_ring_t* ring);
+
+// Samples waiting to be read. Either side may call it.
+static inline uint32_t audio_ring_queued(const audio_ring_t* ring) {
+    return (uint32_t)(atomic_load_explicit(&ring->head, memory_order_acquire)
+                      - atomic_load_explicit(&ring->tail, memory_order_acquire));
+}
+
+// Producer: queues up to count samples, as many as fit. Returns the number queued.
+uint32_t audio_ring_write(audio_ring_t* ring, const int16_t* samples, uint32_t count);
+// Consumer: takes up to count samples. Returns the number taken.
+uint32_t audio_ring_read(audio_ring_t* ring, int16_t* samples, uint32_t count);
+
+// Square wave with a continuous phase across frames and on/off switches
+typedef struct {
+    uint32_t sample_rate;
+    uint32_t phase;            // 32-bit fixed-point fraction of a period
+    uint32_t step;             // phase advance per sample
+    uint32_t frame_remainder;  // sample_rate % 60 carried between frames
+} audio_tone_t;
+
+void audio_tone_init(audio_tone_t* tone, uint32_t sample_rate, uint32_t frequency);
+// Samples in the next 60 Hz frame (sample_rate / 60, the remainder spread over the frames)
+uint32_t audio_tone_frame_length(audio_tone_t* tone);
+// Renders count samples of the tone, or silence, into samples
+void audio_tone_render(audio_tone_t* tone, bool on, int16_t* samples, uint32_t count);
+
+#endif // AUDIO_H
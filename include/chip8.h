@@ -3,19 +3,40 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "config.h"
+#include "trace.h"
+#include "jit.h"
+#include "profile.h"
 
 #define MEMORY_SIZE 4096
+#define MEMORY_ADDRESS_MASK (MEMORY_SIZE - 1) // guest addresses wrap at 4 KB
 #define DISPLAY_WIDTH 64
 #define DISPLAY_HEIGHT 32
 #define NUM_REGISTERS 16
 #define STACK_LEVELS 16
 #define NUM_KEYS 16
 #define FONT_START_ADDRESS 0x50
+#define TIMER_RATE 60 // Hz
+#define MEMORY_PAGE_SIZE 64 // granularity of memory_dirty, one bit per page
 
+// Behaviour variants, selected per instance in chip8_t.quirks
+#define CHIP8_QUIRK_LEGACY_LOAD_STORE (1u << 0) // Fx55/Fx65 leave I = I + x + 1 (COSMAC VIP)
+
+struct chip8;
+struct chip8_heatmap;
+
+#ifdef CHIP8_PREDECODED_DISPATCH
+// One predecoded instruction, cached per memory address. handler == NULL means not decoded yet.
 typedef struct {
+    bool (*handler)(struct chip8* chip8, uint16_t opcode);
+    uint16_t opcode;
+} chip8_decoded_t;
+#endif
+
+typedef struct chip8 {
     uint8_t memory[MEMORY_SIZE];
-    uint8_t display[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+    uint64_t display[DISPLAY_HEIGHT]; // one bit per pixel, x = 0 is the most significant bit
     uint16_t pc;
     uint16_t I;
     uint16_t stack[STACK_LEVELS];
@@ -23,14 +44,53 @@ typedef struct {
     uint8_t V[NUM_REGISTERS];
     uint8_t delay_timer;
     uint8_t sound_timer;
+    uint32_t clock_rate;   // emulated instructions per second
+    uint64_t cycles;       // instructions executed since chip8_initialize
+    uint64_t timer_ticks;  // 60 Hz timer ticks delivered since chip8_initialize
+    uint64_t idle_cycles;  // part of cycles fast-forwarded through polling loops instead of executed
+    uint32_t quirks;       // CHIP8_QUIRK_* flags
+    uint64_t rng_state;    // xorshift64* state for Cxkk, never 0
+    uint64_t unknown_opcodes; // op_unknown executions, only the first is reported
     uint8_t keypad[NUM_KEYS];
     bool draw_flag;
+    uint64_t memory_dirty; // bit n set when memory page n was written, cleared by the consumer
+    trace_level_t trace_level;
+    trace_writer_t* tracer;
+    chip8_profile_t* profile; // set by --profile, runs then go through the reference interpreter
+    struct chip8_heatmap* heatmap; // set by --heatmap, same
+#ifdef CHIP8_PREDECODED_DISPATCH
+    chip8_decoded_t decoded[MEMORY_SIZE];
+#endif
+#ifdef CHIP8_JIT
+    chip8_jit_t* jit;
+#endif
+#ifdef CHIP8_AOT
+    bool aot_code_modified; // a store changed translated code, blocks are validated before running
+#endif
 } chip8_t;
 
 void chip8_initialize(chip8_t* chip8, chip8_config* config);
+void chip8_shutdown(chip8_t* chip8);
 void chip8_load_rom(chip8_t* chip8, const char* filename);
+// Copies a program to 0x200. Returns 0 on success, 1 if it does not fit.
+int chip8_load_program(chip8_t* chip8, const uint8_t* program, size_t size);
+void chip8_seed_random(chip8_t* chip8, uint64_t seed);
+// For code that stores to chip8->memory itself (e.g. restoring a snapshot), keeps decoded code and memory_dirty coherent
+void chip8_memory_written(chip8_t* chip8, uint16_t address, uint16_t length);
 void chip8_emulate_cycle(chip8_t* chip8);
-void update_timers(chip8_t* chip8, uint32_t* last_timer_update);
+void chip8_run_cycles(chip8_t* chip8, uint32_t count);
+uint32_t chip8_cycles_until_tick(const chip8_t* chip8);
+void update_timers(chip8_t* chip8);
 void log_state(chip8_t* chip8);
 
+// 64-bit FNV-1a of the display, identical on every host
+uint64_t chip8_display_hash(const uint64_t display[DISPLAY_HEIGHT]);
+
+// Expands the bit-packed display into one byte (0 or 1) per pixel, row-major
+void chip8_display_to_bytes(const uint64_t display[DISPLAY_HEIGHT], uint8_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT]);
+
+static inline bool chip8_get_pixel(const chip8_t* chip8, int x, int y) {
+    return (chip8->display[y] >> (DISPLAY_WIDTH - 1 - x)) & 1;
+}
+
 #endif
@@ -3,6 +3,10 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "trace.h"
+
+#define DEFAULT_CLOCK_RATE 500 // Hz
+#define DEFAULT_STATE_PATH "chip8.state"
 
 typedef struct {
     const char *rom_path;
@@ -11,6 +15,23 @@ typedef struct {
     uint32_t clock_rate; 
     uint32_t scale_factor; 
     bool legacy_mode;
+    uint64_t seed;             // Cxkk PRNG seed, time-based unless given with --seed
+    bool memory_visualiser;
+    uint32_t visualiser_rate; // memory visualiser refreshes per second
+    trace_level_t trace_level;
+    const char *trace_path;
+    bool turbo;                // run uncapped and report throughput
+    uint32_t present_interval; // in turbo mode, present every Nth emulated frame
+    const char *state_path;    // save state written by F5 and dumps, read by F9
+    const char *load_state_path; // save state restored before the first cycle, or NULL
+    uint32_t rewind_seconds;   // rewind history length, 0 disables rewinding
+    uint32_t rewind_budget_kb; // memory cap for the rewind history
+    const char *record_path;   // input movie written while running, or NULL
+    const char *replay_path;   // input movie replayed headless instead of running, or NULL
+    const char *profile_path;  // prefix of the profile reports written at exit, or NULL
+    uint32_t audio_buffer;     // audio device buffer requested from the driver in samples, a power of two
+    const char *stats_path;    // host loop statistics file or unix:<socket>, or NULL
+    const char *heatmap_path;  // memory access histogram written at exit, or NULL
 } chip8_config;
 
 int parse_arguments(int argc, char *argv[], chip8_config *config);
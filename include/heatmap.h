@@ -0,0 +1,60 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <stdint.h>
+#include "chip8.h"
+
+/*
+    Memory access heatmap (--heatmap <file>). While enabled, every
+    instruction runs through the reference interpreter and the core counts,
+    per address:
+        - HEAT_EXECUTE: instruction fetches (both bytes of the opcode)
+        - HEAT_READ:    I-relative loads by Dxyn and Fx65
+        - HEAT_WRITE:   stores by Fx33 and Fx55
+    The memory visualiser shows the counts as a decaying heatmap, and at
+    exit they are written as a binary histogram: a heatmap_file_header_t
+    followed by HEAT_KINDS arrays of MEMORY_SIZE uint64_t counts, in
+    HEAT_* order and host byte order.
+*/
+
+#define HEATMAP_MAGIC "C8HM"
+#define HEATMAP_VERSION 1
+#define HEATMAP_DECAY 0.75f // share of a level that survives one visualiser refresh
+
+enum { HEAT_EXECUTE, HEAT_READ, HEAT_WRITE, HEAT_KINDS };
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t kinds;       // HEAT_KINDS
+    uint32_t memory_size; // MEMORY_SIZE
+    uint32_t reserved;
+} heatmap_file_header_t; // 16 bytes, no padding
+
+struct chip8_heatmap {
+    uint64_t counts[HEAT_KINDS][MEMORY_SIZE]; // since power-on
+    uint64_t seen[HEAT_KINDS][MEMORY_SIZE];   // counts at the last heatmap_decay
+    float levels[HEAT_KINDS][MEMORY_SIZE];    // decayed recent activity, for display
+    char* path;
+};
+
+typedef struct chip8_heatmap chip8_heatmap_t;
+
+// Returns NULL (and reports why) if the heatmap cannot be allocated
+chip8_heatmap_t* heatmap_open(const char* path);
+// Writes the histogram and a working-set summary, then frees the heatmap. Returns 0 on success.
+int heatmap_close(chip8_heatmap_t* heatmap);
+
+static inline void heatmap_count(chip8_heatmap_t* heatmap, int kind, uint16_t address, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++)
+        heatmap->counts[kind][(address + i) & MEMORY_ADDRESS_MASK]++;
+}
+
+/*
+    Folds the accesses since the previous call into the levels (each level
+    decays by HEATMAP_DECAY first) and returns them as display intensities,
+    0-255 on a log scale, one per kind and address.
+*/
+void heatmap_decay(chip8_heatmap_t* heatmap, uint8_t intensity[HEAT_KINDS][MEMORY_SIZE]);
+
+#endif // HEATMAP_H
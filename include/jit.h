@@ -0,0 +1,31 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdint.h>
+
+/*
+    Basic-block dynamic recompiler to x86-64 (build with make DISPATCH=jit).
+    Straight-line runs of instructions are translated into native code that
+    operates directly on chip8_t. Blocks end at any instruction that may
+    change the PC (jumps, calls, returns, skips, Fx0A) or store to memory
+    (Fx33, Fx55), and those are executed through the reference op_* handlers.
+*/
+
+struct chip8;
+typedef struct chip8_jit chip8_jit_t;
+
+chip8_jit_t* jit_create(void);
+void jit_destroy(chip8_jit_t* jit);
+
+/*
+    Runs the block starting at chip8->pc if it fits in the remaining cycle
+    budget, compiling it first if needed. Returns the number of instructions
+    executed, or 0 if no block was run and the caller should interpret one
+    instruction instead.
+*/
+uint32_t jit_run_block(chip8_jit_t* jit, struct chip8* chip8, uint32_t budget);
+
+// Drops all translated code if [address, address + length) overlaps any of it
+void jit_invalidate(chip8_jit_t* jit, uint16_t address, uint16_t length);
+
+#endif // JIT_H
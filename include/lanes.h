@@ -0,0 +1,51 @@
+#ifndef LANES_H
+#define LANES_H
+
+#include <stdint.h>
+#include "chip8.h"
+
+/*
+    Lockstep multi-lane interpreter. Up to CHIP8_LANES machines advance one
+    instruction per step together, with the register file (V0-VF, PC, I and
+    the timers) held as structure-of-arrays so one loop over the lanes
+    handles every machine at once. Memory, display, stack, keypad and PRNG
+    stay in each lane's own chip8_t, which is the lane's memory bank.
+
+    Each step, lanes that fetched the same opcode form a group. ALU,
+    load, skip, jump and timer opcodes run as masked kernels over the whole
+    lane array; everything else (draws, calls, stores, random numbers, key
+    waits) runs the reference op_* handler on each lane of the group. The
+    result for every lane is identical to running its chip8_t alone with
+    chip8_run_cycles and update_timers.
+*/
+
+#define CHIP8_LANES 32
+
+typedef struct {
+    _Alignas(32) uint8_t V[NUM_REGISTERS][CHIP8_LANES];
+    _Alignas(32) uint16_t pc[CHIP8_LANES];
+    _Alignas(32) uint16_t I[CHIP8_LANES];
+    _Alignas(32) uint8_t delay_timer[CHIP8_LANES];
+    _Alignas(32) uint8_t sound_timer[CHIP8_LANES];
+    _Alignas(32) uint8_t active[CHIP8_LANES]; // 0xFF for lanes in use
+    chip8_t* lane[CHIP8_LANES];
+    uint32_t count;
+    uint32_t clock_rate;   // shared by all lanes, as are cycles and timer ticks
+    uint64_t cycles;
+    uint64_t timer_ticks;
+} chip8_lanes_t;
+
+/*
+    Takes over count initialised machines (ROM loaded, seeded). They must
+    share clock_rate, cycles and timer_ticks. Returns 0 on success.
+    The machines' registers are stale until chip8_lanes_sync.
+*/
+int chip8_lanes_init(chip8_lanes_t* lanes, chip8_t* const machines[], uint32_t count);
+
+// Runs every lane for cycles instructions, delivering 60 Hz timer ticks as they fall due
+void chip8_lanes_run(chip8_lanes_t* lanes, uint64_t cycles);
+
+// Writes the lane registers, cycles and timer ticks back into each chip8_t
+void chip8_lanes_sync(chip8_lanes_t* lanes);
+
+#endif // LANES_H
@@ -0,0 +1,69 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "chip8.h"
+
+/*
+    Input movies. A run is fully determined by the ROM, the clock rate, the
+    quirks, the PRNG seed and the keypad transitions with the cycle at which
+    each one happened. A movie file stores exactly that: a movie_header_t
+    followed by event_count movie_event_t, in host byte order. The header
+    also holds the final cycle count and display hash, so a replay can tell
+    whether it reproduced the recorded session.
+
+    Replays apply each transition before the first instruction of its cycle,
+    the same way the host applies polled input, and need no host at all, so
+    they run uncapped.
+*/
+
+#define MOVIE_MAGIC "C8MV"
+#define MOVIE_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t event_size;   // sizeof(movie_event_t)
+    uint32_t clock_rate;
+    uint32_t quirks;       // CHIP8_QUIRK_* flags
+    uint64_t seed;
+    uint64_t rom_hash;     // movie_rom_hash() when recording started
+    uint64_t final_cycles;
+    uint64_t final_display_hash;
+    uint64_t event_count;
+} movie_header_t; // 56 bytes, no padding
+
+typedef struct {
+    uint64_t cycle;
+    uint8_t key;
+    uint8_t down;
+    uint8_t reserved[6];
+} movie_event_t; // 16 bytes, no padding
+
+typedef struct movie_recorder movie_recorder_t;
+
+typedef struct {
+    movie_header_t header;
+    movie_event_t* events;
+} movie_t;
+
+// FNV-1a of program memory (0x200 to the end), taken right after the ROM is loaded
+uint64_t movie_rom_hash(const chip8_t* chip8);
+
+// Starts recording the run of chip8, which was initialised with seed. Returns NULL on failure.
+movie_recorder_t* movie_record_open(const char* path, const chip8_t* chip8, uint64_t seed);
+// Logs every key that differs between before and chip8->keypad, at the current cycle
+void movie_record_keys(movie_recorder_t* recorder, const chip8_t* chip8, const uint8_t before[NUM_KEYS]);
+// Writes the final cycle count and display hash and closes the file. Returns 0 on success.
+int movie_record_close(movie_recorder_t* recorder, const chip8_t* chip8);
+
+// Both return 0 on success and report errors on stderr
+int movie_load(const char* path, movie_t* movie);
+void movie_free(movie_t* movie);
+
+// Runs chip8 from power-on (ROM loaded, initialised from the movie's settings) to the movie's
+// final cycle, feeding its key events. Returns 0 if the final display hash matches.
+int movie_replay(chip8_t* chip8, const movie_t* movie);
+
+#endif // MOVIE_H
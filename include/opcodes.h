@@ -0,0 +1,57 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "chip8.h"
+
+/*
+    Opcode handlers. Each one executes a single instruction and returns true
+    if it took control of the program counter, false if the caller should
+    advance it by 2. Exposed so alternative execution cores can fall back to
+    (or compare against) the reference implementation.
+*/
+typedef bool (*opcode_func_t)(chip8_t* chip8, uint16_t opcode);
+
+// Resolves an opcode to the leaf handler the dispatch tables would run for it on this instance
+opcode_func_t chip8_resolve_handler(const chip8_t* chip8, uint16_t opcode);
+
+bool op_unknown(chip8_t* chip8, uint16_t opcode);
+bool op_00E0(chip8_t* chip8, uint16_t opcode);
+bool op_00EE(chip8_t* chip8, uint16_t opcode);
+bool op_1nnn(chip8_t* chip8, uint16_t opcode);
+bool op_2nnn(chip8_t* chip8, uint16_t opcode);
+bool op_3xkk(chip8_t* chip8, uint16_t opcode);
+bool op_4xkk(chip8_t* chip8, uint16_t opcode);
+bool op_5xy0(chip8_t* chip8, uint16_t opcode);
+bool op_6xkk(chip8_t* chip8, uint16_t opcode);
+bool op_7xkk(chip8_t* chip8, uint16_t opcode);
+bool op_8xy0(chip8_t* chip8, uint16_t opcode);
+bool op_8xy1(chip8_t* chip8, uint16_t opcode);
+bool op_8xy2(chip8_t* chip8, uint16_t opcode);
+bool op_8xy3(chip8_t* chip8, uint16_t opcode);
+bool op_8xy4(chip8_t* chip8, uint16_t opcode);
+bool op_8xy5(chip8_t* chip8, uint16_t opcode);
+bool op_8xy6(chip8_t* chip8, uint16_t opcode);
+bool op_8xy7(chip8_t* chip8, uint16_t opcode);
+bool op_8xyE(chip8_t* chip8, uint16_t opcode);
+bool op_9xy0(chip8_t* chip8, uint16_t opcode);
+bool op_Annn(chip8_t* chip8, uint16_t opcode);
+bool op_Bnnn(chip8_t* chip8, uint16_t opcode);
+bool op_Cxkk(chip8_t* chip8, uint16_t opcode);
+bool op_Dxyn(chip8_t* chip8, uint16_t opcode);
+bool op_Ex9E(chip8_t* chip8, uint16_t opcode);
+bool op_ExA1(chip8_t* chip8, uint16_t opcode);
+bool op_Fx07(chip8_t* chip8, uint16_t opcode);
+bool op_Fx0A(chip8_t* chip8, uint16_t opcode);
+bool op_Fx15(chip8_t* chip8, uint16_t opcode);
+bool op_Fx18(chip8_t* chip8, uint16_t opcode);
+bool op_Fx1E(chip8_t* chip8, uint16_t opcode);
+bool op_Fx29(chip8_t* chip8, uint16_t opcode);
+bool op_Fx33(chip8_t* chip8, uint16_t opcode);
+bool op_Fx55(chip8_t* chip8, uint16_t opcode);
+bool op_Fx55_legacy(chip8_t* chip8, uint16_t opcode);
+bool op_Fx65(chip8_t* chip8, uint16_t opcode);
+bool op_Fx65_legacy(chip8_t* chip8, uint16_t opcode);
+
+#endif // OPCODES_H
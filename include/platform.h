@@ -0,0 +1,82 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "chip8.h"
+#include "config.h"
+#include "heatmap.h"
+
+/*
+    Host interface. main.c reaches video, input, audio, time and logging only
+    through these calls. Exactly one backend is linked in, selected with
+    make PLATFORM=...:
+      sdl  - platform_sdl.c, window, keyboard and memory visualiser (default)
+      null - platform_null.c, headless: no SDL, no window, no console prompts
+    Time and logging are shared by every backend (platform.c).
+*/
+
+typedef struct platform platform_t;
+
+typedef enum {
+    LOG_INFO,
+    LOG_ERROR
+} log_level_t;
+
+// Opens the backend for config. Returns NULL after logging the reason on failure.
+platform_t* platform_create(const chip8_config* config);
+void platform_destroy(platform_t* platform);
+
+// Name of the linked backend, e.g. "sdl"
+const char* platform_name(void);
+
+// True if the host may block on the console for "Press Enter" style prompts
+bool platform_interactive(void);
+
+// Video: show the bit-packed display rows
+void platform_present(platform_t* platform, const uint64_t display[DISPLAY_HEIGHT]);
+
+// Video: refresh the memory visualiser, if the backend has one. memory_dirty has a bit per page
+// that changed since the previous call. With heat (NULL if off, see heatmap_decay) all pages are
+// redrawn with recent accesses overlaid.
+void platform_present_memory(platform_t* platform, const uint8_t memory[MEMORY_SIZE], uint64_t memory_dirty,
+                             const uint8_t heat[HEAT_KINDS][MEMORY_SIZE]);
+
+// Frontend commands, reported by platform_poll_input (the SDL backend binds them to hotkeys)
+#define PLATFORM_CMD_SAVE_STATE (1u << 0) // F5
+#define PLATFORM_CMD_LOAD_STATE (1u << 1) // F9
+#define PLATFORM_CMD_REWIND     (1u << 2) // Backspace, reported on every poll while held
+
+// Threads: platform_create, platform_destroy, video and input calls must come from the thread that
+// created the platform; audio, time and logging may be used from any thread.
+
+// Input: updates keypad from pending host events and sets commands to the PLATFORM_CMD_*
+// requested since the last call. Returns false once the user asked to quit.
+bool platform_poll_input(platform_t* platform, uint8_t keypad[NUM_KEYS], uint32_t* commands);
+
+/*
+    Audio: backends with an audio device play the buzzer samples queued
+    with platform_audio_write (signed 16-bit mono at platform_audio_rate)
+    from an audio callback, and drop whatever would push the queue past
+    their latency cap. Samples must be queued from one thread at a time.
+    Without a device platform_audio_rate is 0 and the buzzer is driven by
+    platform_set_tone, called once per presented frame.
+*/
+uint32_t platform_audio_rate(platform_t* platform);
+// Device buffer in samples, as granted by the device (it may differ from config->audio_buffer)
+uint32_t platform_audio_buffer(platform_t* platform);
+// Samples queued and not yet handed to the device
+uint32_t platform_audio_queued(platform_t* platform);
+// Returns the number of samples queued
+uint32_t platform_audio_write(platform_t* platform, const int16_t* samples, uint32_t count);
+void platform_set_tone(platform_t* platform, bool on);
+
+// Time: CLOCK_MONOTONIC nanoseconds, and an absolute-deadline sleep on the same clock
+uint64_t platform_time_ns(void);
+void platform_sleep_until_ns(uint64_t deadline_ns);
+
+// Logging: LOG_INFO goes to stdout, LOG_ERROR to stderr with an "Error: " prefix
+void platform_log(log_level_t level, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#endif // PLATFORM_H
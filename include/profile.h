@@ -0,0 +1,49 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+/*
+    Guest program profiler (--profile <prefix>). While enabled, every
+    instruction runs through the reference interpreter and is counted:
+        - per opcode class, indexed like opcode_table and its subtables
+          (see PROFILE_CLASS_*)
+        - per PC address
+        - per calling context: 2nnn enters a subroutine and 00EE leaves it,
+          which gives call-graph edges and self counts per call stack
+    When the machine shuts down three reports are written:
+        <prefix>.txt     flat profile: classes, hot addresses, functions, call graph
+        <prefix>.folded  collapsed stacks ("main;sub_2A4;sub_300 1234" per line)
+                         for flamegraph.pl, speedscope and similar tools
+        <prefix>.csv     one row per executed address
+*/
+
+// Class index layout: top nibbles 1-7 and 9-D map to themselves, 0/8/E/F to their subtable
+#define PROFILE_CLASS_8xxx 16                          // + low nibble
+#define PROFILE_CLASS_0xxx (PROFILE_CLASS_8xxx + 16)   // + low byte
+#define PROFILE_CLASS_Exxx (PROFILE_CLASS_0xxx + 256)  // + low byte
+#define PROFILE_CLASS_Fxxx (PROFILE_CLASS_Exxx + 256)  // + low byte
+#define PROFILE_CLASSES (PROFILE_CLASS_Fxxx + 256)
+
+#define PROFILE_MAX_FRAMES 4096 // calling contexts tracked, deeper calls are charged to their caller
+
+typedef struct chip8_profile chip8_profile_t;
+
+// Returns NULL (and reports why) if the profile cannot be allocated
+chip8_profile_t* profile_open(const char* prefix);
+// Counts one instruction, before it executes
+void profile_instruction(chip8_profile_t* profile, uint16_t pc, uint16_t opcode);
+// Writes the reports and frees the profile. Returns 0 on success.
+int profile_close(chip8_profile_t* profile);
+
+static inline uint16_t profile_class(uint16_t opcode) {
+    switch (opcode >> 12) {
+        case 0x0: return PROFILE_CLASS_0xxx + (opcode & 0xFF);
+        case 0x8: return PROFILE_CLASS_8xxx + (opcode & 0x0F);
+        case 0xE: return PROFILE_CLASS_Exxx + (opcode & 0xFF);
+        case 0xF: return PROFILE_CLASS_Fxxx + (opcode & 0xFF);
+        default: return opcode >> 12;
+    }
+}
+
+#endif // PROFILE_H
@@ -0,0 +1,41 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "chip8.h"
+#include "snapshot.h"
+
+/*
+    Rewind history: one snapshot_state_t per emulated frame, kept in a byte
+    ring of fixed size. Every REWIND_KEYFRAME_INTERVAL frames a keyframe is
+    stored; the frames in between hold only the XOR of their state against
+    that keyframe, run-length encoded in 64-bit words. Between two frames
+    little more than the registers, counters, a few display rows and a few
+    memory bytes change, so a delta is usually on the order of a hundred bytes.
+
+    When the ring is out of frames or bytes the oldest entries are dropped.
+    Dropping a keyframe also drops the deltas that depend on it, so the
+    oldest retained frame is always a keyframe. Stepping back decodes at most
+    one keyframe (cached) and one delta, a few microseconds.
+*/
+
+#define REWIND_KEYFRAME_INTERVAL 60 // frames, one keyframe per emulated second at 60 Hz
+
+typedef struct rewind_buffer rewind_buffer_t;
+
+// max_frames: history length in frames. budget_bytes: ring size, raised to a minimum of a few full states.
+rewind_buffer_t* rewind_create(uint32_t max_frames, size_t budget_bytes);
+void rewind_destroy(rewind_buffer_t* rewind);
+
+// Appends the current state of chip8 as the newest frame
+void rewind_push(rewind_buffer_t* rewind, const chip8_t* chip8);
+
+// Drops the newest frame and restores chip8 to the one before it.
+// Returns 0 on success, 1 if there is no older frame (chip8 is unchanged then).
+int rewind_step_back(rewind_buffer_t* rewind, chip8_t* chip8);
+
+uint32_t rewind_frames(const rewind_buffer_t* rewind);
+size_t rewind_bytes_used(const rewind_buffer_t* rewind);
+
+#endif // REWIND_H
@@ -0,0 +1,61 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "chip8.h"
+
+/*
+    Save states. A state file is a snapshot_header_t followed by one
+    snapshot_state_t, both fixed-size and in host byte order, so loading is
+    an mmap, a header and checksum check and a handful of copies. Anything
+    that changes the layout of snapshot_state_t must bump SNAPSHOT_VERSION.
+
+    The snapshot holds everything that decides how the machine runs on:
+    memory, display, stack, registers, timers, keypad, draw flag, clock
+    rate, cycle and timer tick counters, quirks and the PRNG state. Host
+    settings (tracing, memory_dirty, decoded and translated code caches)
+    are not saved; they are reset on restore.
+*/
+
+#define SNAPSHOT_MAGIC "C8SS"
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t state_size; // sizeof(snapshot_state_t)
+    uint64_t checksum;   // snapshot_checksum() of the state that follows
+} snapshot_header_t; // 16 bytes, no padding
+
+typedef struct {
+    uint64_t display[DISPLAY_HEIGHT];
+    uint64_t cycles;
+    uint64_t timer_ticks;
+    uint64_t rng_state;
+    uint64_t unknown_opcodes;
+    uint32_t clock_rate;
+    uint32_t quirks;
+    uint16_t pc;
+    uint16_t I;
+    uint16_t stack[STACK_LEVELS];
+    uint8_t memory[MEMORY_SIZE];
+    uint8_t V[NUM_REGISTERS];
+    uint8_t keypad[NUM_KEYS];
+    uint8_t stack_pointer;
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+    uint8_t draw_flag;
+} snapshot_state_t; // 4464 bytes, no padding
+
+// In-memory snapshots, for callers that keep states around themselves
+void snapshot_capture(const chip8_t* chip8, snapshot_state_t* state);
+// Returns 0 on success, 1 if the state is not one a machine can be in (nothing is changed then)
+int snapshot_restore(chip8_t* chip8, const snapshot_state_t* state);
+uint64_t snapshot_checksum(const snapshot_state_t* state);
+
+// State files. Both return 0 on success and report errors on stderr.
+// Saving writes a temporary file and renames it, so an old state is never left half-overwritten.
+int chip8_save_state(const chip8_t* chip8, const char* path);
+int chip8_load_state(chip8_t* chip8, const char* path);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,57 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Host loop statistics (--stats <target>). main times every phase of the
+    emulation and presentation loops; the durations go into log-bucketed
+    latency histograms
+    (four buckets per power of two, so percentiles are within 12.5%) along
+    with the emulation loop's frame-budget overruns and missed frame
+    deadlines. Recording is thread-safe; exporting is done by one thread. Once per
+    STATS_INTERVAL_NS a JSON snapshot with p50/p99/max per phase for the
+    last interval and the session totals is exported:
+        <file>        rewritten in place (via a temporary file and rename)
+        unix:<path>   one line per snapshot to a SOCK_STREAM Unix socket;
+                      reconnects at the next snapshot if the reader goes
+                      away, drops snapshots rather than block the emulator
+*/
+
+#define STATS_INTERVAL_NS 1000000000ull
+#define STATS_BUCKETS 256
+
+typedef struct {
+    uint64_t buckets[STATS_BUCKETS];
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+} latency_histogram_t;
+
+void histogram_record(latency_histogram_t* histogram, uint64_t ns);
+// Upper bound of the bucket holding the given fraction (0-1) of samples, capped at the maximum
+uint64_t histogram_percentile(const latency_histogram_t* histogram, double fraction);
+
+typedef struct stats_exporter stats_exporter_t;
+
+// phase_names must outlive the exporter. Returns NULL (and reports why) on failure.
+stats_exporter_t* stats_open(const char* target, const char* const phase_names[], int phase_count);
+
+// Records one sample of phase (an index into phase_names)
+void stats_record_phase(stats_exporter_t* stats, int phase, uint64_t ns);
+
+/*
+    Records one emulation loop iteration: busy_ns is its time excluding
+    waiting for the next frame, late_frames the frame deadlines that passed
+    before their frame could start.
+*/
+void stats_record_frame(stats_exporter_t* stats, uint64_t busy_ns, uint64_t budget_ns, uint32_t late_frames);
+
+// Exports a snapshot if STATS_INTERVAL_NS passed since the last one (or always, if force)
+void stats_export(stats_exporter_t* stats, uint64_t now_ns, uint64_t cycles, bool force);
+
+// Exports a final snapshot of anything not yet exported and frees the exporter
+void stats_close(stats_exporter_t* stats, uint64_t now_ns, uint64_t cycles);
+
+#endif // STATS_H
@@ -0,0 +1,51 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+/*
+    Per-cycle tracing.
+        - TRACE_OFF:    nothing is recorded (default)
+        - TRACE_TEXT:   legacy printf trace to stdout, one line per cycle
+        - TRACE_BINARY: fixed-size records written to a file by a background thread
+
+    Build with -DCHIP8_NO_TRACE (make TRACE=0) to compile tracing out of
+    chip8_emulate_cycle entirely.
+*/
+typedef enum {
+    TRACE_OFF = 0,
+    TRACE_TEXT,
+    TRACE_BINARY
+} trace_level_t;
+
+#define TRACE_MAGIC "C8TR"
+#define TRACE_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+} trace_file_header_t;
+
+typedef struct {
+    uint16_t pc;
+    uint16_t opcode;
+    uint16_t I;
+    uint8_t V[16];
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+} trace_record_t; // 24 bytes, no padding
+
+#define TRACE_BUFFER_RECORDS 8192
+
+typedef struct trace_writer trace_writer_t;
+
+trace_writer_t* trace_writer_open(const char* filename);
+void trace_writer_push(trace_writer_t* writer, const trace_record_t* record);
+void trace_writer_close(trace_writer_t* writer);
+
+void trace_print_record(FILE* out, const trace_record_t* record);
+
+#endif // TRACE_H
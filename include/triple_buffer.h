@@ -0,0 +1,67 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "chip8.h"
+#include "heatmap.h"
+
+/*
+    Lock-free triple buffer carrying finished frames from the emulation
+    thread to the presentation thread. Each side owns one slot; the third
+    sits between them in `middle`. Publishing swaps the producer's slot into
+    the middle and marks it fresh, acquiring swaps a fresh middle slot out to
+    the consumer. Neither side ever waits: the producer may overwrite frames
+    the consumer never saw, and the consumer always gets the newest complete
+    one. Exactly one thread may publish and one may acquire.
+*/
+
+#define TRIPLE_BUFFER_FRESH 4u // set in middle while it holds a frame the consumer has not taken
+#define TRIPLE_BUFFER_INDEX 3u
+
+typedef struct {
+    uint64_t display[DISPLAY_HEIGHT];
+    bool tone;                              // sound timer running
+    bool has_memory;                        // memory (and heat) captured for the visualiser
+    bool has_heat;
+    uint64_t memory_sequence;               // counts captures, so the consumer can tell if it missed one
+    uint64_t memory_dirty;                  // pages written since the previous capture
+    uint8_t memory[MEMORY_SIZE];
+    uint8_t heat[HEAT_KINDS][MEMORY_SIZE];  // heatmap_decay intensities
+} host_frame_t;
+
+typedef struct {
+    host_frame_t slots[3];
+    _Alignas(64) atomic_uint middle;
+    _Alignas(64) unsigned back;  // producer's slot
+    _Alignas(64) unsigned front; // consumer's slot
+} triple_buffer_t;
+
+static inline void triple_buffer_init(triple_buffer_t* buffer) {
+    buffer->back = 0;
+    atomic_init(&buffer->middle, 1);
+    buffer->front = 2;
+}
+
+// Producer: the slot to fill next
+static inline host_frame_t* triple_buffer_back(triple_buffer_t* buffer) {
+    return &buffer->slots[buffer->back];
+}
+
+// Producer: hands the filled slot to the consumer and takes the previous middle one back
+static inline void triple_buffer_publish(triple_buffer_t* buffer) {
+    buffer->back = atomic_exchange_explicit(&buffer->middle, buffer->back | TRIPLE_BUFFER_FRESH,
+                                            memory_order_acq_rel) & TRIPLE_BUFFER_INDEX;
+}
+
+// Consumer: the newest published frame, or NULL if nothing was published since the last call
+static inline const host_frame_t* triple_buffer_acquire(triple_buffer_t* buffer) {
+    if (!(atomic_load_explicit(&buffer->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH))
+        return NULL;
+    buffer->front = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel)
+        & TRIPLE_BUFFER_INDEX;
+    return &buffer->slots[buffer->front];
+}
+
+#endif // TRIPLE_BUFFER_H
@@ -0,0 +1,90 @@
+#include "audio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chip8.h"
+
+audio_ring_t* audio_ring_create(uint32_t capacity) {
+    uint32_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    audio_ring_t* ring = calloc(1, sizeof(*ring));
+    if (ring)
+        ring->samples = calloc(size, sizeof(*ring->samples));
+    if (!ring || !ring->samples) {
+        fprintf(stderr, "Error: Could not allocate the audio ring\n");
+        free(ring);
+        return NULL;
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->underruns, 0);
+    return ring;
+}
+
+void audio_ring_destroy(audio_ring_t* ring) {
+    if (!ring)
+        return;
+    free(ring->samples);
+    free(ring);
+}
+
+uint32_t audio_ring_write(audio_ring_t* ring, const int16_t* samples, uint32_t count) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t space = ring->mask + 1 - (head - tail);
+    if (count > space)
+        count = space;
+    // At most two copies: up to the end of the buffer, then from its start
+    uint32_t start = head & ring->mask;
+    uint32_t first = count < ring->mask + 1 - start ? count : ring->mask + 1 - start;
+    memcpy(ring->samples + start, samples, first * sizeof(*samples));
+    memcpy(ring->samples, samples + first, (count - first) * sizeof(*samples));
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+    return count;
+}
+
+uint32_t audio_ring_read(audio_ring_t* ring, int16_t* samples, uint32_t count) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t available = head - tail;
+    if (count > available) {
+        count = available;
+        atomic_fetch_add_explicit(&ring->underruns, 1, memory_order_relaxed);
+    }
+    uint32_t start = tail & ring->mask;
+    uint32_t first = count < ring->mask + 1 - start ? count : ring->mask + 1 - start;
+    memcpy(samples, ring->samples + start, first * sizeof(*samples));
+    memcpy(samples + first, ring->samples, (count - first) * sizeof(*samples));
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
+
+void audio_tone_init(audio_tone_t* tone, uint32_t sample_rate, uint32_t frequency) {
+    tone->sample_rate = sample_rate;
+    tone->phase = 0;
+    tone->step = (uint32_t)(((uint64_t)frequency << 32) / sample_rate);
+    tone->frame_remainder = 0;
+}
+
+uint32_t audio_tone_frame_length(audio_tone_t* tone) {
+    uint32_t length = tone->sample_rate / TIMER_RATE;
+    tone->frame_remainder += tone->sample_rate % TIMER_RATE;
+    if (tone->frame_remainder >= TIMER_RATE) {
+        tone->frame_remainder -= TIMER_RATE;
+        length++;
+    }
+    return length;
+}
+
+void audio_tone_render(audio_tone_t* tone, bool on, int16_t* samples, uint32_t count) {
+    // The phase keeps running while silent, so the wave never restarts mid-period
+    int16_t level = on ? AUDIO_AMPLITUDE : 0;
+    uint32_t phase = tone->phase;
+    for (uint32_t i = 0; i < count; i++) {
+        samples[i] = (phase & 0x80000000u) ? (int16_t)-level : level;
+        phase += tone->step;
+    }
+    tone->phase = phase;
+}
@@ -1,13 +1,13 @@
 #include <stdio.h>
 #include <string.h>
-#include <SDL2/SDL.h>
 #include <stdbool.h>
 #include "chip8.h"
 #include "config.h"
-#include <stdlib.h>
-#include <time.h>
-
-typedef bool (*opcode_func_t)(chip8_t* chip8, uint16_t opcode);
+#include "opcodes.h"
+#include "heatmap.h"
+#ifdef CHIP8_AOT
+#include "aot.h"
+#endif
 
 static const uint8_t chip8_font_set[80] = {
     0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
@@ -28,6 +28,70 @@ static const uint8_t chip8_font_set[80] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
+/*
+    Called by every instruction (and the ROM loader) that stores to memory,
+    so caches derived from memory contents can be kept coherent.
+*/
+static inline void chip8_on_memory_write(chip8_t* chip8, uint16_t address, uint16_t length) {
+    address &= MEMORY_ADDRESS_MASK;
+    if ((uint32_t)address + length > MEMORY_SIZE) {
+        // The store wrapped around the end of memory
+        uint16_t head = MEMORY_SIZE - address;
+        chip8_on_memory_write(chip8, address, head);
+        chip8_on_memory_write(chip8, 0, length - head);
+        return;
+    }
+    if (length > 0 && address < MEMORY_SIZE) {
+        uint32_t last = (uint32_t)address + length - 1;
+        if (last >= MEMORY_SIZE)
+            last = MEMORY_SIZE - 1;
+        for (uint32_t page = address / MEMORY_PAGE_SIZE; page <= last / MEMORY_PAGE_SIZE; page++)
+            chip8->memory_dirty |= 1ull << page;
+    }
+#ifdef CHIP8_PREDECODED_DISPATCH
+    // An instruction starting one byte before the write also overlaps it
+    uint16_t first = (address > 0) ? address - 1 : 0;
+    uint32_t end = (uint32_t)address + length;
+    if (end > MEMORY_SIZE)
+        end = MEMORY_SIZE;
+    for (uint32_t a = first; a < end; a++)
+        chip8->decoded[a].handler = NULL;
+#endif
+#ifdef CHIP8_JIT
+    if (chip8->jit)
+        jit_invalidate(chip8->jit, address, length);
+#endif
+#ifdef CHIP8_AOT
+    chip8_aot_check_write(chip8, address, length);
+#endif
+}
+
+void chip8_memory_written(chip8_t* chip8, uint16_t address, uint16_t length) {
+    chip8_on_memory_write(chip8, address, length);
+}
+
+/*
+    Per-instance PRNG for Cxkk: xorshift64*, seeded through splitmix64 so
+    nearby seeds give unrelated sequences. The same seed always produces the
+    same run, and instances never share state.
+*/
+void chip8_seed_random(chip8_t* chip8, uint64_t seed) {
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    chip8->rng_state = z ? z : 1;
+}
+
+static inline uint8_t chip8_random_byte(chip8_t* chip8) {
+    uint64_t x = chip8->rng_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    chip8->rng_state = x;
+    return (uint8_t)((x * 0x2545F4914F6CDD1Dull) >> 56);
+}
+
 /*
     All opcodes follow one of the following patterns:
         - ?nnn
@@ -36,6 +100,16 @@ static const uint8_t chip8_font_set[80] = {
         - ?xkn
 */
 
+int chip8_load_program(chip8_t* chip8, const uint8_t* program, size_t size) {
+    if (size > MEMORY_SIZE - 0x200) {
+        fprintf(stderr, "Error: ROM file is too large!\n");
+        return 1;
+    }
+    memcpy(&chip8->memory[0x200], program, size);
+    chip8_on_memory_write(chip8, 0x200, (uint16_t)size);
+    return 0;
+}
+
 void chip8_load_rom(chip8_t* chip8, const char* filename) {
     FILE* rom_file = fopen(filename, "rb");
     if (!rom_file) {
@@ -50,13 +124,35 @@ void chip8_load_rom(chip8_t* chip8, const char* filename) {
     if (rom_size > (4096 - 0x200)) {
         fprintf(stderr, "Error: ROM file is too large!\n");
     } else {
-        fread(&chip8->memory[0x200], 1, rom_size, rom_file);
-        printf("Loaded %ld bytes from %s\n", rom_size, filename);
+        uint8_t program[MEMORY_SIZE - 0x200];
+        size_t read = fread(program, 1, rom_size, rom_file);
+        if (chip8_load_program(chip8, program, read) == 0)
+            printf("Loaded %ld bytes from %s\n", rom_size, filename);
     }
 
     fclose(rom_file);
 }
 
+uint64_t chip8_display_hash(const uint64_t display[DISPLAY_HEIGHT]) {
+    // FNV-1a over the rows, most significant byte first so the hash is host independent
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            hash ^= (display[y] >> shift) & 0xFF;
+            hash *= 0x100000001B3ull;
+        }
+    }
+    return hash;
+}
+
+void chip8_display_to_bytes(const uint64_t display[DISPLAY_HEIGHT], uint8_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT]) {
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        uint64_t row = display[y];
+        for (int x = 0; x < DISPLAY_WIDTH; x++)
+            pixels[(y * DISPLAY_WIDTH) + x] = (row >> (DISPLAY_WIDTH - 1 - x)) & 1;
+    }
+}
+
 static inline uint8_t get_x(uint16_t opcode) {
     return (opcode >> 8) & 0x0F;
 }
@@ -78,7 +174,10 @@ static inline uint16_t get_nnn(uint16_t opcode) {
 }
 
 bool op_unknown(chip8_t* chip8, uint16_t opcode) {
-    fprintf(stderr, "Unknown opcode: 0x%04X\n", opcode);
+    // Only the first is reported, a ROM running through data would flood the console
+    if (chip8->unknown_opcodes++ == 0)
+        fprintf(stderr, "Unknown opcode: 0x%04X at 0x%03X (further unknown opcodes are counted only)\n",
+                opcode, chip8->pc);
     return false;
 }
 
@@ -91,7 +190,9 @@ bool op_00E0(chip8_t* chip8, uint16_t opcode) {
 }
 
 bool op_00EE(chip8_t* chip8, uint16_t opcode) {
-    chip8->pc = chip8->stack[--chip8->stack_pointer];
+    // The stack is a ring, so ROMs that underflow or overflow it stay inside the instance
+    chip8->stack_pointer = (chip8->stack_pointer - 1) & (STACK_LEVELS - 1);
+    chip8->pc = chip8->stack[chip8->stack_pointer];
     return false;
 }
 
@@ -106,7 +207,8 @@ bool op_2nnn(chip8_t* chip8, uint16_t opcode) { // 2nnn -> CALL addr
         then puts the current PC on the top
         of the stack. The PC is then set to nnn.
     */
-    chip8->stack[chip8->stack_pointer++] = chip8->pc;
+    chip8->stack[chip8->stack_pointer] = chip8->pc;
+    chip8->stack_pointer = (chip8->stack_pointer + 1) & (STACK_LEVELS - 1);
     chip8->pc = get_nnn(opcode);
     return true;
 }
@@ -308,7 +410,7 @@ bool op_Cxkk(chip8_t* chip8, uint16_t opcode) { // Cxkk -> RND Vx, byte
         The interpreter generates a random number from 0 to 255, which is then
         ANDed with the value kk. The results are stored in Vx. 
     */
-    chip8->V[get_x(opcode)] = ((uint8_t)(rand() % 256) & get_kk(opcode));
+    chip8->V[get_x(opcode)] = (chip8_random_byte(chip8) & get_kk(opcode));
     return false;
 }
 
@@ -331,35 +433,29 @@ bool op_Dxyn(chip8_t* chip8, uint16_t opcode) { // Dxyn -> DRW Vx, Vy, nibble
     uint8_t start_x = chip8->V[x_coord_reg];
     uint8_t start_y = chip8->V[y_coord_reg];
 
+    if (chip8->heatmap)
+        heatmap_count(chip8->heatmap, HEAT_READ, chip8->I, height);
+
     // Reset the collision flag
     chip8->V[0xF] = 0;
 
+    // Each display row is one 64-bit word with x = 0 in the most significant bit,
+    // so horizontal wrapping is a rotate of the sprite byte placed at the top
+    unsigned shift = start_x % DISPLAY_WIDTH;
+
     // Loop over each row of the sprite (n rows)
     for (int y_line = 0; y_line < height; y_line++) {
         // Get the byte of sprite data for the current row
-        uint8_t sprite_byte = chip8->memory[chip8->I + y_line];
-
-        // Loop over each bit of the sprite byte (8 bits wide)
-        for (int x_bit = 0; x_bit < 8; x_bit++) {
-            // Check if the current sprite bit is set to 1
-            // (0x80 is 10000000 in binary. We shift it right to check each bit)
-            if ((sprite_byte & (0x80 >> x_bit)) != 0) {
-                // Calculate the target screen coordinates, with wrapping
-                int screen_x = (start_x + x_bit) % DISPLAY_WIDTH;
-                int screen_y = (start_y + y_line) % DISPLAY_HEIGHT;
-
-                // Convert 2D screen coords to 1D display array index
-                int pixel_index = screen_x + (screen_y * DISPLAY_WIDTH);
-
-                // Check for collision: if the screen pixel is already 1, set VF flag
-                if (chip8->display[pixel_index] == 1) {
-                    chip8->V[0xF] = 1;
-                }
+        uint8_t sprite_byte = chip8->memory[(chip8->I + y_line) & MEMORY_ADDRESS_MASK];
+        uint64_t sprite_row = (uint64_t)sprite_byte << (DISPLAY_WIDTH - 8);
+        sprite_row = (sprite_row >> shift) | (sprite_row << ((DISPLAY_WIDTH - shift) % DISPLAY_WIDTH));
 
-                // XOR the pixel onto the display buffer
-                chip8->display[pixel_index] ^= 1;
-            }
-        }
+        uint64_t* display_row = &chip8->display[(start_y + y_line) % DISPLAY_HEIGHT];
+
+        // Collision if any sprite pixel lands on a lit pixel, then XOR the row in
+        if (*display_row & sprite_row)
+            chip8->V[0xF] = 1;
+        *display_row ^= sprite_row;
     }
 
     // Set the draw flag so the screen updates in the main loop
@@ -378,7 +474,7 @@ bool op_Ex9E(chip8_t* chip8, uint16_t opcode) { // SKP Vx
         of Vx is currently in the down position, PC is increased by 2. 
     */
     uint8_t x = get_x(opcode);
-    uint8_t key_value = chip8->V[x]; 
+    uint8_t key_value = chip8->V[x] & 0x0F; 
     if (chip8->keypad[key_value] == 1)
         chip8->pc += 2;
     return false;
@@ -391,7 +487,7 @@ bool op_ExA1(chip8_t* chip8, uint16_t opcode) { // SKNP Vx
         of Vx is currently in the up position, PC is increased by 2.
     */
     uint8_t x = get_x(opcode);
-    uint8_t key_value = chip8->V[x]; 
+    uint8_t key_value = chip8->V[x] & 0x0F; 
     if (chip8->keypad[key_value] == 0)
         chip8->pc += 2;
     return false;
@@ -471,9 +567,12 @@ bool op_Fx33(chip8_t* chip8, uint16_t opcode) { // Fx33 -> LD B, Vx
     */
     uint8_t Vx = chip8->V[get_x(opcode)];
     uint16_t I = chip8->I;
-    chip8->memory[I] = Vx / 100 ;
-    chip8->memory[I + 1] = (Vx / 10) % 10;
-    chip8->memory[I + 2] = Vx % 10;
+    chip8->memory[I & MEMORY_ADDRESS_MASK] = Vx / 100 ;
+    chip8->memory[(I + 1) & MEMORY_ADDRESS_MASK] = (Vx / 10) % 10;
+    chip8->memory[(I + 2) & MEMORY_ADDRESS_MASK] = Vx % 10;
+    chip8_on_memory_write(chip8, I, 3);
+    if (chip8->heatmap)
+        heatmap_count(chip8->heatmap, HEAT_WRITE, I, 3);
     return false;
 }
 
@@ -483,7 +582,10 @@ bool op_Fx55(chip8_t* chip8, uint16_t opcode) { // Fx55 -> LD [I], Vx
     */
     uint8_t x = get_x(opcode);
     for (int i = 0; i <= x; i++)
-        chip8->memory[chip8->I + i] = chip8->V[i];
+        chip8->memory[(chip8->I + i) & MEMORY_ADDRESS_MASK] = chip8->V[i];
+    chip8_on_memory_write(chip8, chip8->I, x + 1);
+    if (chip8->heatmap)
+        heatmap_count(chip8->heatmap, HEAT_WRITE, chip8->I, x + 1);
     return false;
 }
 
@@ -494,7 +596,10 @@ bool op_Fx55_legacy(chip8_t* chip8, uint16_t opcode) { // Fx55 -> LD [I], Vx
     */
     uint8_t x = get_x(opcode);
     for (int i = 0; i <= x; i++)
-        chip8->memory[chip8->I + i] = chip8->V[i];
+        chip8->memory[(chip8->I + i) & MEMORY_ADDRESS_MASK] = chip8->V[i];
+    chip8_on_memory_write(chip8, chip8->I, x + 1);
+    if (chip8->heatmap)
+        heatmap_count(chip8->heatmap, HEAT_WRITE, chip8->I, x + 1);
     chip8->I += x + 1;
     return false;
 }
@@ -505,7 +610,9 @@ bool op_Fx65(chip8_t* chip8, uint16_t opcode) { // Fx65 -> LD Vx, [I]
     */
     uint8_t x = get_x(opcode);
     for (int i = 0; i <= x ; i++)
-        chip8->V[i] = chip8->memory[chip8->I + i];
+        chip8->V[i] = chip8->memory[(chip8->I + i) & MEMORY_ADDRESS_MASK];
+    if (chip8->heatmap)
+        heatmap_count(chip8->heatmap, HEAT_READ, chip8->I, x + 1);
     return false;
 }
 
@@ -516,12 +623,14 @@ bool op_Fx65_legacy(chip8_t* chip8, uint16_t opcode) { // Fx65 -> LD Vx, [I]
     */
     uint8_t x = get_x(opcode);
     for (int i = 0; i <= x ; i++)
-        chip8->V[i] = chip8->memory[chip8->I + i];
+        chip8->V[i] = chip8->memory[(chip8->I + i) & MEMORY_ADDRESS_MASK];
+    if (chip8->heatmap)
+        heatmap_count(chip8->heatmap, HEAT_READ, chip8->I, x + 1);
     chip8->I += x + 1;
     return false;
 }
 
-static opcode_func_t opcode_table[16] = {
+static const opcode_func_t opcode_table[16] = {
     [0x0] = op_0xxx,  // Special case for 00E0 and 00EE
     [0x1] = op_1nnn,
     [0x2] = op_2nnn,
@@ -540,12 +649,12 @@ static opcode_func_t opcode_table[16] = {
     [0xF] = op_Fxxx   // Special case for misc ops
 };
 
-static opcode_func_t opcode_0xxx_table[0xEF] = {
+static const opcode_func_t opcode_0xxx_table[0xEF] = {
     [0xE0] = op_00E0,
     [0xEE] = op_00EE
 };
 
-static opcode_func_t opcode_8xxx_table[] = {
+static const opcode_func_t opcode_8xxx_table[] = {
     [0x0] = op_8xy0,
     [0x1] = op_8xy1,
     [0x2] = op_8xy2,
@@ -557,12 +666,12 @@ static opcode_func_t opcode_8xxx_table[] = {
     [0xE] = op_8xyE
 };
 
-static opcode_func_t opcode_Exxx_table[] = {
+static const opcode_func_t opcode_Exxx_table[] = {
     [0x9E] = op_Ex9E,
     [0xA1] = op_ExA1
 };
 
-static opcode_func_t opcode_Fxxx_table[] = {
+static const opcode_func_t opcode_Fxxx_table[] = {
     [0x07] = op_Fx07,
     [0x0A] = op_Fx0A,
     [0x15] = op_Fx15,
@@ -574,6 +683,23 @@ static opcode_func_t opcode_Fxxx_table[] = {
     [0x65] = op_Fx65
 };
 
+// Used instead of opcode_Fxxx_table by instances with CHIP8_QUIRK_LEGACY_LOAD_STORE
+static const opcode_func_t opcode_Fxxx_legacy_table[] = {
+    [0x07] = op_Fx07,
+    [0x0A] = op_Fx0A,
+    [0x15] = op_Fx15,
+    [0x18] = op_Fx18,
+    [0x1E] = op_Fx1E,
+    [0x29] = op_Fx29,
+    [0x33] = op_Fx33,
+    [0x55] = op_Fx55_legacy,
+    [0x65] = op_Fx65_legacy
+};
+
+static inline const opcode_func_t* chip8_Fxxx_table(const chip8_t* chip8) {
+    return (chip8->quirks & CHIP8_QUIRK_LEGACY_LOAD_STORE) ? opcode_Fxxx_legacy_table : opcode_Fxxx_table;
+}
+
 bool op_0xxx(chip8_t* chip8, uint16_t opcode) {
     uint8_t kk = get_kk(opcode);
 
@@ -622,27 +748,106 @@ bool op_Fxxx(chip8_t* chip8, uint16_t opcode) {
     if (kk >= sizeof(opcode_Fxxx_table) / sizeof(opcode_func_t)) {
         return op_unknown(chip8, opcode);
     }
-    opcode_func_t func = opcode_Fxxx_table[kk];
+    opcode_func_t func = chip8_Fxxx_table(chip8)[kk];
     if (func) {
         return func(chip8, opcode);
     }
     return op_unknown(chip8, opcode);
 }
 
+opcode_func_t chip8_resolve_handler(const chip8_t* chip8, uint16_t opcode) {
+    opcode_func_t func;
+    switch (opcode >> 12) {
+        case 0x0:
+            func = (get_kk(opcode) < sizeof(opcode_0xxx_table) / sizeof(opcode_func_t))
+                ? opcode_0xxx_table[get_kk(opcode)] : NULL;
+            break;
+        case 0x8:
+            func = (get_n(opcode) < sizeof(opcode_8xxx_table) / sizeof(opcode_func_t))
+                ? opcode_8xxx_table[get_n(opcode)] : NULL;
+            break;
+        case 0xE:
+            func = (get_kk(opcode) < sizeof(opcode_Exxx_table) / sizeof(opcode_func_t))
+                ? opcode_Exxx_table[get_kk(opcode)] : NULL;
+            break;
+        case 0xF:
+            func = (get_kk(opcode) < sizeof(opcode_Fxxx_table) / sizeof(opcode_func_t))
+                ? chip8_Fxxx_table(chip8)[get_kk(opcode)] : NULL;
+            break;
+        default:
+            func = opcode_table[opcode >> 12];
+            break;
+    }
+    return func ? func : op_unknown;
+}
+
 void chip8_initialize(chip8_t* chip8, chip8_config* config) {
     memset(chip8, 0, sizeof(chip8_t));
     chip8->pc = 0x200;
-    if (config->legacy_mode) {
-        opcode_Fxxx_table[0x55] = op_Fx55_legacy;
-        opcode_Fxxx_table[0x65] = op_Fx65_legacy;
-    }
-    srand(time(NULL));
+    chip8->clock_rate = config->clock_rate ? config->clock_rate : DEFAULT_CLOCK_RATE;
+    if (config->legacy_mode)
+        chip8->quirks |= CHIP8_QUIRK_LEGACY_LOAD_STORE;
+    chip8_seed_random(chip8, config->seed);
     memcpy(&chip8->memory[FONT_START_ADDRESS], chip8_font_set, sizeof(chip8_font_set));
+    chip8->memory_dirty = ~0ull;
+
+#ifdef CHIP8_JIT
+    chip8->jit = jit_create();
+#endif
+
+    chip8->trace_level = config->trace_level;
+    if (chip8->trace_level == TRACE_BINARY) {
+        chip8->tracer = trace_writer_open(config->trace_path);
+        if (!chip8->tracer)
+            chip8->trace_level = TRACE_OFF;
+    }
+    if (config->profile_path)
+        chip8->profile = profile_open(config->profile_path);
+    if (config->heatmap_path)
+        chip8->heatmap = heatmap_open(config->heatmap_path);
 }
 
-void chip8_emulate_cycle(chip8_t* chip8) { // Fetch->Decode->Execute opcodes 
-    log_state(chip8);
-    uint16_t opcode = (chip8->memory[chip8->pc] << 8) | chip8->memory[chip8->pc+1];
+void chip8_shutdown(chip8_t* chip8) {
+    trace_writer_close(chip8->tracer);
+    chip8->tracer = NULL;
+    chip8->trace_level = TRACE_OFF;
+    profile_close(chip8->profile);
+    chip8->profile = NULL;
+    heatmap_close(chip8->heatmap);
+    chip8->heatmap = NULL;
+#ifdef CHIP8_JIT
+    jit_destroy(chip8->jit);
+    chip8->jit = NULL;
+#endif
+}
+
+static inline void chip8_fill_trace_record(chip8_t* chip8, uint16_t opcode, trace_record_t* record) {
+    record->pc = chip8->pc;
+    record->opcode = opcode;
+    record->I = chip8->I;
+    memcpy(record->V, chip8->V, sizeof(record->V));
+    record->delay_timer = chip8->delay_timer;
+    record->sound_timer = chip8->sound_timer;
+}
+
+#ifndef CHIP8_NO_TRACE
+static void chip8_trace(chip8_t* chip8, uint16_t opcode) {
+    trace_record_t record;
+    chip8_fill_trace_record(chip8, opcode, &record);
+    if (chip8->trace_level == TRACE_BINARY)
+        trace_writer_push(chip8->tracer, &record);
+    else
+        trace_print_record(stdout, &record);
+}
+#endif
+
+static inline void chip8_execute(chip8_t* chip8) { // Fetch->Decode->Execute opcodes 
+    chip8->pc &= MEMORY_ADDRESS_MASK;
+    uint16_t opcode = (chip8->memory[chip8->pc] << 8) | chip8->memory[(chip8->pc + 1) & MEMORY_ADDRESS_MASK];
+#ifndef CHIP8_NO_TRACE
+    if (chip8->trace_level != TRACE_OFF)
+        chip8_trace(chip8, opcode);
+#endif
 
     uint8_t opcode_op = ((opcode >> 12) & 0x0F);
     opcode_func_t func = opcode_table[opcode_op];
@@ -651,26 +856,345 @@ void chip8_emulate_cycle(chip8_t* chip8) { // Fetch->Decode->Execute opcodes
     
 }
 
-void update_timers(chip8_t* chip8, uint32_t* last_timer_update) {
-    uint32_t current_time = SDL_GetTicks();
-    if (current_time - *last_timer_update >= (1000 / 60)) {
-        if (chip8->delay_timer > 0) {
-            chip8->delay_timer--;
+#ifdef CHIP8_THREADED_DISPATCH
+/*
+    Direct-threaded dispatch core (GCC labels-as-values).
+    Every handler label ends with its own copy of the fetch and the indirect
+    jump, so the branch predictor sees one jump site per opcode instead of the
+    single shared call in opcode_table. Decoding is two-level: the top nibble
+    picks a label, 0/8/E/F then index a second label table with no bounds
+    checks. The op_* handlers are called directly so they get inlined and keep
+    their exact semantics, including the PC-control return value.
+*/
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+static void chip8_dispatch(chip8_t* chip8, uint32_t count) {
+    static void* const top_labels[16] = {
+        &&L_0xxx, &&L_1nnn, &&L_2nnn, &&L_3xkk, &&L_4xkk, &&L_5xy0, &&L_6xkk, &&L_7xkk,
+        &&L_8xxx, &&L_9xy0, &&L_Annn, &&L_Bnnn, &&L_Cxkk, &&L_Dxyn, &&L_Exxx, &&L_Fxxx
+    };
+    static void* const labels_0xxx[256] = {
+        [0x00 ... 0xFF] = &&L_unknown,
+        [0xE0] = &&L_00E0,
+        [0xEE] = &&L_00EE
+    };
+    static void* const labels_8xxx[16] = {
+        [0x0 ... 0xF] = &&L_unknown,
+        [0x0] = &&L_8xy0, [0x1] = &&L_8xy1, [0x2] = &&L_8xy2, [0x3] = &&L_8xy3,
+        [0x4] = &&L_8xy4, [0x5] = &&L_8xy5, [0x6] = &&L_8xy6, [0x7] = &&L_8xy7,
+        [0xE] = &&L_8xyE
+    };
+    static void* const labels_Exxx[256] = {
+        [0x00 ... 0xFF] = &&L_unknown,
+        [0x9E] = &&L_Ex9E,
+        [0xA1] = &&L_ExA1
+    };
+    static void* const labels_Fxxx[256] = {
+        [0x00 ... 0xFF] = &&L_unknown,
+        [0x07] = &&L_Fx07, [0x0A] = &&L_Fx0A, [0x15] = &&L_Fx15, [0x18] = &&L_Fx18,
+        [0x1E] = &&L_Fx1E, [0x29] = &&L_Fx29, [0x33] = &&L_Fx33,
+        [0x55] = &&L_Fx55, [0x65] = &&L_Fx65
+    };
+
+    uint16_t opcode;
+
+#ifndef CHIP8_NO_TRACE
+#define THREADED_TRACE() \
+        if (chip8->trace_level != TRACE_OFF) \
+            chip8_trace(chip8, opcode);
+#else
+#define THREADED_TRACE()
+#endif
+
+#define DISPATCH() do { \
+        if (count-- == 0) \
+            return; \
+        chip8->pc &= MEMORY_ADDRESS_MASK; \
+        opcode = (chip8->memory[chip8->pc] << 8) | chip8->memory[(chip8->pc + 1) & MEMORY_ADDRESS_MASK]; \
+        THREADED_TRACE() \
+        goto *top_labels[opcode >> 12]; \
+    } while (0)
+
+#define EXECUTE(handler) do { \
+        if (!handler(chip8, opcode)) \
+            chip8->pc += 2; \
+        DISPATCH(); \
+    } while (0)
+
+    DISPATCH();
+
+L_0xxx: goto *labels_0xxx[opcode & 0xFF];
+L_8xxx: goto *labels_8xxx[opcode & 0x0F];
+L_Exxx: goto *labels_Exxx[opcode & 0xFF];
+L_Fxxx: goto *labels_Fxxx[opcode & 0xFF];
+
+L_unknown: EXECUTE(op_unknown);
+L_00E0: EXECUTE(op_00E0);
+L_00EE: EXECUTE(op_00EE);
+L_1nnn: EXECUTE(op_1nnn);
+L_2nnn: EXECUTE(op_2nnn);
+L_3xkk: EXECUTE(op_3xkk);
+L_4xkk: EXECUTE(op_4xkk);
+L_5xy0: EXECUTE(op_5xy0);
+L_6xkk: EXECUTE(op_6xkk);
+L_7xkk: EXECUTE(op_7xkk);
+L_8xy0: EXECUTE(op_8xy0);
+L_8xy1: EXECUTE(op_8xy1);
+L_8xy2: EXECUTE(op_8xy2);
+L_8xy3: EXECUTE(op_8xy3);
+L_8xy4: EXECUTE(op_8xy4);
+L_8xy5: EXECUTE(op_8xy5);
+L_8xy6: EXECUTE(op_8xy6);
+L_8xy7: EXECUTE(op_8xy7);
+L_8xyE: EXECUTE(op_8xyE);
+L_9xy0: EXECUTE(op_9xy0);
+L_Annn: EXECUTE(op_Annn);
+L_Bnnn: EXECUTE(op_Bnnn);
+L_Cxkk: EXECUTE(op_Cxkk);
+L_Dxyn: EXECUTE(op_Dxyn);
+L_Ex9E: EXECUTE(op_Ex9E);
+L_ExA1: EXECUTE(op_ExA1);
+L_Fx07: EXECUTE(op_Fx07);
+L_Fx0A: EXECUTE(op_Fx0A);
+L_Fx15: EXECUTE(op_Fx15);
+L_Fx18: EXECUTE(op_Fx18);
+L_Fx1E: EXECUTE(op_Fx1E);
+L_Fx29: EXECUTE(op_Fx29);
+L_Fx33: EXECUTE(op_Fx33);
+// Fx55/Fx65 honour the instance's CHIP8_QUIRK_LEGACY_LOAD_STORE
+L_Fx55: if (chip8->quirks & CHIP8_QUIRK_LEGACY_LOAD_STORE) EXECUTE(op_Fx55_legacy); EXECUTE(op_Fx55);
+L_Fx65: if (chip8->quirks & CHIP8_QUIRK_LEGACY_LOAD_STORE) EXECUTE(op_Fx65_legacy); EXECUTE(op_Fx65);
+
+#undef EXECUTE
+#undef DISPATCH
+#undef THREADED_TRACE
+}
+#pragma GCC diagnostic pop
+#elif defined(CHIP8_PREDECODED_DISPATCH)
+/*
+    Predecoded dispatch core.
+    Each address caches the fetched opcode and the leaf handler it resolves
+    to, so the common case skips the fetch, the two-level table walk and its
+    bounds checks. Entries are dropped by chip8_on_memory_write whenever an
+    instruction or the ROM loader stores over them, which keeps
+    self-modifying ROMs correct.
+*/
+static void chip8_dispatch(chip8_t* chip8, uint32_t count) {
+    while (count--) {
+        if (chip8->pc >= MEMORY_SIZE - 1) {
+            // The opcode would straddle the end of memory, leave it to the reference path
+            chip8_execute(chip8);
+            continue;
+        }
+        chip8_decoded_t* entry = &chip8->decoded[chip8->pc];
+        if (!entry->handler) {
+            entry->opcode = (chip8->memory[chip8->pc] << 8) | chip8->memory[chip8->pc+1];
+            entry->handler = chip8_resolve_handler(chip8, entry->opcode);
+        }
+#ifndef CHIP8_NO_TRACE
+        if (chip8->trace_level != TRACE_OFF)
+            chip8_trace(chip8, entry->opcode);
+#endif
+        if (!entry->handler(chip8, entry->opcode))
+            chip8->pc += 2;
+    }
+}
+#elif defined(CHIP8_JIT)
+/*
+    JIT dispatch core. Whole translated blocks run while they fit in the
+    remaining budget; the tail of the budget, untranslatable addresses and
+    traced runs fall back to single interpreted cycles, so the executed
+    instruction count is exact.
+*/
+static void chip8_dispatch(chip8_t* chip8, uint32_t count) {
+    while (count > 0) {
+        uint32_t executed = 0;
+        if (chip8->jit && chip8->trace_level == TRACE_OFF)
+            executed = jit_run_block(chip8->jit, chip8, count);
+        if (executed == 0) {
+            chip8_execute(chip8);
+            executed = 1;
+        }
+        count -= executed;
+    }
+}
+#elif defined(CHIP8_AOT)
+/*
+    Ahead-of-time translated ROM. Same budget rules as the JIT core: blocks
+    run whole, anything untranslated or modified is interpreted.
+*/
+static void chip8_dispatch(chip8_t* chip8, uint32_t count) {
+    while (count > 0) {
+        uint32_t executed = 0;
+        if (chip8->trace_level == TRACE_OFF)
+            executed = chip8_aot_run_block(chip8, count);
+        if (executed == 0) {
+            chip8_execute(chip8);
+            executed = 1;
+        }
+        count -= executed;
+    }
+}
+#else
+static void chip8_dispatch(chip8_t* chip8, uint32_t count) {
+    while (count--)
+        chip8_execute(chip8);
+}
+#endif
+
+/*
+    Profiled and heatmapped runs: every instruction goes through
+    chip8_execute, so counts, call edges and fetches are exact whatever
+    DISPATCH core the build uses.
+*/
+static void chip8_instrumented_cycles(chip8_t* chip8, uint32_t count) {
+    while (count--) {
+        uint16_t pc = chip8->pc & MEMORY_ADDRESS_MASK;
+        if (chip8->profile)
+            profile_instruction(chip8->profile, pc, (chip8->memory[pc] << 8) | chip8->memory[(pc + 1) & MEMORY_ADDRESS_MASK]);
+        if (chip8->heatmap)
+            heatmap_count(chip8->heatmap, HEAT_EXECUTE, pc, 2);
+        chip8_execute(chip8);
+    }
+}
+
+/*
+    Idle-loop fast-forward. The host only changes the keypad and the timers
+    between chip8_run_cycles calls, so within one batch a polling loop that
+    reads nothing else comes back to the same state on every pass: Fx07,
+    Ex9E/ExA1 and a waiting Fx0A read them, 3xkk/4xkk/5xy0/9xy0 compare,
+    6xkk/8xy0/Annn load and 1nnn jumps back. chip8_idle_period simulates up to
+    IDLE_LOOP_MAX instructions from pc on copies of V and I and returns the
+    loop length if they lead back to pc with nothing changed, else 0. Whole
+    passes of such a loop are then counted without being executed.
+*/
+#define IDLE_LOOP_MAX 8  // longest polling loop recognised, in instructions
+#define IDLE_CHUNK 256   // instructions dispatched between two idle checks
+
+static uint32_t chip8_idle_period(const chip8_t* chip8) {
+    uint8_t V[NUM_REGISTERS];
+    memcpy(V, chip8->V, sizeof(V));
+    uint16_t I = chip8->I;
+    uint16_t start = chip8->pc;
+    if (start > MEMORY_ADDRESS_MASK)
+        return 0;
+    uint16_t pc = start;
+    for (uint32_t length = 1; length <= IDLE_LOOP_MAX; length++) {
+        uint16_t opcode = (chip8->memory[pc] << 8) | chip8->memory[(pc + 1) & MEMORY_ADDRESS_MASK];
+        uint8_t x = get_x(opcode);
+        uint16_t next = pc + 2;
+        switch (opcode >> 12) {
+            case 0x1: next = get_nnn(opcode); break;
+            case 0x3: if (V[x] == get_kk(opcode)) next += 2; break;
+            case 0x4: if (V[x] != get_kk(opcode)) next += 2; break;
+            case 0x5: if (V[x] == V[get_y(opcode)]) next += 2; break;
+            case 0x6: V[x] = get_kk(opcode); break;
+            case 0x8:
+                if (get_n(opcode) != 0x0)
+                    return 0;
+                V[x] = V[get_y(opcode)];
+                break;
+            case 0x9: if (V[x] != V[get_y(opcode)]) next += 2; break;
+            case 0xA: I = get_nnn(opcode); break;
+            case 0xE:
+                if (get_kk(opcode) == 0x9E) {
+                    if (chip8->keypad[V[x] & 0x0F] == 1)
+                        next += 2;
+                } else if (get_kk(opcode) == 0xA1) {
+                    if (chip8->keypad[V[x] & 0x0F] == 0)
+                        next += 2;
+                } else {
+                    return 0;
+                }
+                break;
+            case 0xF:
+                if (get_kk(opcode) == 0x07) {
+                    V[x] = chip8->delay_timer;
+                } else if (get_kk(opcode) == 0x0A) {
+                    for (int i = 0; i < NUM_KEYS; i++)
+                        if (chip8->keypad[i] == 1)
+                            return 0;
+                    next = pc; // still waiting
+                } else {
+                    return 0;
+                }
+                break;
+            default:
+                return 0;
         }
-        if (chip8->sound_timer > 0) {
-            chip8->sound_timer--;
-            if (chip8->sound_timer == 0) {
-                printf("BEEP!\n");
-            }
+        // The unmasked pc must match too, it is what chip8->pc holds after the pass
+        if (next == start)
+            return (memcmp(V, chip8->V, sizeof(V)) == 0 && I == chip8->I) ? length : 0;
+        pc = next & MEMORY_ADDRESS_MASK;
+    }
+    return 0;
+}
+
+/*
+    chip8_dispatch with idle checks between chunks. A timer tick just before
+    the batch usually changes what the loop reads (Fx07 gives a new value),
+    so the first check fails; the second comes one loop length later, once
+    a pass has settled, then every IDLE_CHUNK instructions.
+*/
+static void chip8_idle_dispatch(chip8_t* chip8, uint32_t count) {
+    uint32_t chunk_size = IDLE_LOOP_MAX;
+    while (count > 0) {
+        uint32_t period = chip8_idle_period(chip8);
+        if (period) {
+            uint32_t skipped = count - count % period;
+            chip8->idle_cycles += skipped;
+            chip8_dispatch(chip8, count - skipped);
+            return;
         }
-        *last_timer_update = current_time;
+        uint32_t chunk = count < chunk_size ? count : chunk_size;
+        chip8_dispatch(chip8, chunk);
+        count -= chunk;
+        chunk_size = IDLE_CHUNK;
+    }
+}
+
+void chip8_emulate_cycle(chip8_t* chip8) {
+    if (chip8->profile || chip8->heatmap)
+        chip8_instrumented_cycles(chip8, 1);
+    else
+        chip8_execute(chip8);
+    chip8->cycles++;
+}
+
+void chip8_run_cycles(chip8_t* chip8, uint32_t count) {
+    if (chip8->profile || chip8->heatmap)
+        chip8_instrumented_cycles(chip8, count);
+    else if (chip8->trace_level == TRACE_OFF)
+        chip8_idle_dispatch(chip8, count);
+    else
+        chip8_dispatch(chip8, count);
+    chip8->cycles += count;
+}
+
+/*
+    The 60 Hz timers are driven by the emulated cycle count, not wall time:
+    tick k is due once ceil(k * clock_rate / 60) cycles have run. This keeps
+    runs reproducible at any clock rate, however the host paces them.
+*/
+uint32_t chip8_cycles_until_tick(const chip8_t* chip8) {
+    uint64_t next_tick = ((chip8->timer_ticks + 1) * chip8->clock_rate + (TIMER_RATE - 1)) / TIMER_RATE;
+    return (chip8->cycles >= next_tick) ? 0 : (uint32_t)(next_tick - chip8->cycles);
+}
+
+void update_timers(chip8_t* chip8) {
+    if (chip8->delay_timer > 0) {
+        chip8->delay_timer--;
+    }
+    if (chip8->sound_timer > 0) {
+        chip8->sound_timer--;
     }
+    chip8->timer_ticks++;
 }
 
 void log_state(chip8_t* chip8) {
-    uint16_t opcode = (chip8->memory[chip8->pc] << 8) | chip8->memory[chip8->pc+1];
-    printf("[0x%4X] 0x%4X | V0-VF[", chip8->pc, opcode);
-    for (int i = 0; i < NUM_REGISTERS; i++)
-        printf("%02X ", chip8->V[i]);
-    printf("]\n");
+    uint16_t pc = chip8->pc & MEMORY_ADDRESS_MASK;
+    uint16_t opcode = (chip8->memory[pc] << 8) | chip8->memory[(pc + 1) & MEMORY_ADDRESS_MASK];
+    trace_record_t record;
+    chip8_fill_trace_record(chip8, opcode, &record);
+    trace_print_record(stdout, &record);
 }
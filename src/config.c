@@ -1,8 +1,11 @@
 #include "config.h"
+#include "audio.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <getopt.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <time.h>
 
 static void print_usage(const char *prog_name) {
     fprintf(stderr, "Usage: %s [options] <rom_path>\n", prog_name);
@@ -10,9 +13,26 @@ static void print_usage(const char *prog_name) {
     fprintf(stderr, "  -h, --help            Show this help message and exit\n");
     fprintf(stderr, "  -s, --step            Enable step-through mode (press Enter for each cycle)\n");
     fprintf(stderr, "  -l, --legacy          Enable legacy opcode behavior around I register\n");
+    fprintf(stderr, "  -R, --seed <n>        Seed for the random number generator (default: time-based)\n");
     fprintf(stderr, "  -c, --cycles <count>  Run for a specific number of cycles and exit\n");
     fprintf(stderr, "  -r, --clock-rate <hz> Set the CPU clock speed in Hertz (default: 500)\n");
     fprintf(stderr, "  -S, --scale <factor>  Set the display scale factor (default: 10)\n");
+    fprintf(stderr, "  -v, --visualiser      Open the memory visualiser window\n");
+    fprintf(stderr, "  -V, --vis-rate <hz>   Memory visualiser refresh rate (default: 15)\n");
+    fprintf(stderr, "  -t, --trace <file>    Write a binary per-cycle trace to <file> (decode with chip8-trace)\n");
+    fprintf(stderr, "  -T, --trace-text      Print a per-cycle trace to stdout (slow)\n");
+    fprintf(stderr, "  -u, --turbo           Run as fast as possible and report MIPS and frame times\n");
+    fprintf(stderr, "  -p, --present-every <n> In turbo mode, present only every nth frame (default: 1)\n");
+    fprintf(stderr, "  -f, --state-file <file> Save state used by F5/F9 and dumps (default: %s)\n", DEFAULT_STATE_PATH);
+    fprintf(stderr, "  -L, --load-state <file> Restore a save state before running\n");
+    fprintf(stderr, "  -w, --rewind <seconds> Keep this much history for Backspace rewinding (default: off)\n");
+    fprintf(stderr, "  -W, --rewind-budget <KB> Memory cap for the rewind history (default: 2048)\n");
+    fprintf(stderr, "  -m, --record <file>   Record key presses and the seed to a movie file\n");
+    fprintf(stderr, "  -M, --replay <file>   Replay a movie headless and uncapped, check its final display\n");
+    fprintf(stderr, "  -P, --profile <prefix> Profile the ROM, write <prefix>.txt, .folded and .csv at exit\n");
+    fprintf(stderr, "  -H, --heatmap <file>  Count memory reads, writes and fetches; shown by -v, written at exit\n");
+    fprintf(stderr, "  -A, --audio-buffer <n> Audio device buffer to request in samples, a power of two (default: %d)\n", AUDIO_DEFAULT_BUFFER);
+    fprintf(stderr, "  -J, --stats <file|unix:path> Export host frame-phase latency histograms as JSON every second\n");
 }
 
 void print_emulator_configuration(chip8_config *config) {
@@ -21,11 +41,38 @@ void print_emulator_configuration(chip8_config *config) {
     printf("ROM Path:      %s\n", config->rom_path);
     printf("Step Mode:     %s\n", config->step_mode ? "ON" : "OFF");
     printf("Legacy Mode:   %s\n", config->legacy_mode ? "ON" : "OFF");
+    printf("Seed:          %" PRIu64 "\n", config->seed);
     if (config->cycles_to_run != -1) {
         printf("Cycles to Run: %ld\n", config->cycles_to_run);
     }
     printf("Clock Rate:    %u Hz\n", config->clock_rate); // Use %u for unsigned
     printf("Scale Factor:  %ux\n", config->scale_factor); // Use %u for unsigned
+    if (config->memory_visualiser)
+        printf("Visualiser:    ON (%u Hz)\n", config->visualiser_rate);
+    else
+        printf("Visualiser:    OFF\n");
+    if (config->trace_level == TRACE_BINARY)
+        printf("Trace:         %s\n", config->trace_path);
+    else
+        printf("Trace:         %s\n", config->trace_level == TRACE_TEXT ? "TEXT" : "OFF");
+    printf("State File:    %s\n", config->state_path);
+    if (config->load_state_path)
+        printf("Load State:    %s\n", config->load_state_path);
+    if (config->rewind_seconds > 0)
+        printf("Rewind:        %u s (up to %u KB)\n", config->rewind_seconds, config->rewind_budget_kb);
+    if (config->record_path)
+        printf("Record:        %s\n", config->record_path);
+    if (config->replay_path)
+        printf("Replay:        %s\n", config->replay_path);
+    if (config->profile_path)
+        printf("Profile:       %s\n", config->profile_path);
+    if (config->heatmap_path)
+        printf("Heatmap:       %s\n", config->heatmap_path);
+    printf("Audio Buffer:  %u samples requested\n", config->audio_buffer);
+    if (config->stats_path)
+        printf("Stats:         %s\n", config->stats_path);
+    if (config->turbo)
+        printf("Turbo:         ON (present every %u frame%s)\n", config->present_interval, config->present_interval == 1 ? "" : "s");
     printf("-----------------------\n");
 }
 
@@ -40,26 +87,71 @@ static int parse_int64(const char *str, int64_t *val) {
     return 0;
 }
 
+static int parse_uint64(const char *str, uint64_t *val) {
+    char *endptr;
+    errno = 0;
+    *val = strtoull(str, &endptr, 0);
+
+    if (endptr == str || *endptr != '\0' || *str == '-' || errno == ERANGE) {
+        return -1;
+    }
+    return 0;
+}
+
 int parse_arguments(int argc, char *argv[], chip8_config *config) {
     
     // Set default values
     config->rom_path = NULL;
     config->step_mode = false;
     config->cycles_to_run = -1;
-    config->clock_rate = 500;
+    config->clock_rate = DEFAULT_CLOCK_RATE;
     config->scale_factor = 10;
     config->legacy_mode = false;
+    config->seed = (uint64_t)time(NULL);
+    config->memory_visualiser = false;
+    config->visualiser_rate = 15;
+    config->trace_level = TRACE_OFF;
+    config->trace_path = NULL;
+    config->turbo = false;
+    config->present_interval = 1;
+    config->state_path = DEFAULT_STATE_PATH;
+    config->load_state_path = NULL;
+    config->rewind_seconds = 0;
+    config->rewind_budget_kb = 2048;
+    config->record_path = NULL;
+    config->replay_path = NULL;
+    config->profile_path = NULL;
+    config->heatmap_path = NULL;
+    config->audio_buffer = AUDIO_DEFAULT_BUFFER;
+    config->stats_path = NULL;
     
     static struct option long_options[] = {
         {"help",       no_argument,       0, 'h'},
         {"step",       no_argument,       0, 's'},
         {"legacy",     no_argument,       0, 'l'},
+        {"seed",       required_argument, 0, 'R'},
         {"cycles",     required_argument, 0, 'c'},
         {"clock-rate", required_argument, 0, 'r'},
         {"scale",      required_argument, 0, 'S'},
+        {"visualiser", no_argument,       0, 'v'},
+        {"vis-rate",   required_argument, 0, 'V'},
+        {"trace",      required_argument, 0, 't'},
+        {"trace-text", no_argument,       0, 'T'},
+        {"turbo",      no_argument,       0, 'u'},
+        {"present-every", required_argument, 0, 'p'},
+        {"state-file", required_argument, 0, 'f'},
+        {"load-state", required_argument, 0, 'L'},
+        {"rewind",     required_argument, 0, 'w'},
+        {"rewind-budget", required_argument, 0, 'W'},
+        {"record",     required_argument, 0, 'm'},
+        {"replay",     required_argument, 0, 'M'},
+        {"profile",    required_argument, 0, 'P'},
+        {"heatmap",    required_argument, 0, 'H'},
+        {"audio-buffer", required_argument, 0, 'A'},
+        {"stats",      required_argument, 0, 'J'},
         {0, 0, 0, 0}
     };
-    const char *short_opts = "hslc:r:S:";
+    const char *short_opts = "hslR:c:r:S:vV:t:Tup:f:L:w:W:m:M:P:H:J:A:";
 
     // 3. The parsing loop
     int opt_char;
@@ -68,22 +160,56 @@ int parse_arguments(int argc, char *argv[], chip8_config *config) {
             case 'h': print_usage(argv[0]); exit(0);
             case 's': config->step_mode = true; break;
             case 'l': config->legacy_mode = true; break;
+            case 'R':
+                if (parse_uint64(optarg, &config->seed) != 0) {
+                    fprintf(stderr, "Error: Invalid number for seed: '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 't':
+                config->trace_level = TRACE_BINARY;
+                config->trace_path = optarg;
+                break;
+            case 'T': config->trace_level = TRACE_TEXT; break;
             case 'c':
                 if (parse_int64(optarg, &config->cycles_to_run) != 0 || config->cycles_to_run <= 0) {
                     fprintf(stderr, "Error: Invalid number for cycles: '%s'\n", optarg);
                     return 1;
                 }
                 break;
+            case 'v': config->memory_visualiser = true; break;
+            case 'u': config->turbo = true; break;
+            case 'f': config->state_path = optarg; break;
+            case 'L': config->load_state_path = optarg; break;
+            case 'm': config->record_path = optarg; break;
+            case 'M': config->replay_path = optarg; break;
+            case 'P': config->profile_path = optarg; break;
+            case 'H': config->heatmap_path = optarg; break;
+            case 'J': config->stats_path = optarg; break;
             case 'r':
             case 'S':
+            case 'V':
+            case 'p':
+            case 'w':
+            case 'W':
+            case 'A':
                 int64_t val;
-                if (parse_int64(optarg, &val) != 0 || val <= 0) {
+                if (parse_int64(optarg, &val) != 0 || val <= 0 || val > UINT32_MAX
+                    || (opt_char == 'w' && val > UINT32_MAX / 60) // --rewind is kept as 60 Hz frames
+                    || (opt_char == 'A' && (val > 32768 || (val & (val - 1))))) {
                     fprintf(stderr, "Error: Invalid positive integer for --%s: '%s'\n", 
-                            (opt_char == 'r' ? "clock-rate" : "scale"), optarg);
+                            (opt_char == 'r' ? "clock-rate" : opt_char == 'S' ? "scale" :
+                             opt_char == 'V' ? "vis-rate" : opt_char == 'p' ? "present-every" :
+                             opt_char == 'w' ? "rewind" : opt_char == 'W' ? "rewind-budget" : "audio-buffer"), optarg);
                     return 1;
                 }
                 if (opt_char == 'r') config->clock_rate = (uint32_t)val;
-                else config->scale_factor = (uint32_t)val;
+                else if (opt_char == 'S') config->scale_factor = (uint32_t)val;
+                else if (opt_char == 'V') config->visualiser_rate = (uint32_t)val;
+                else if (opt_char == 'p') config->present_interval = (uint32_t)val;
+                else if (opt_char == 'w') config->rewind_seconds = (uint32_t)val;
+                else if (opt_char == 'W') config->rewind_budget_kb = (uint32_t)val;
+                else config->audio_buffer = (uint32_t)val;
                 break;
             case '?': print_usage(argv[0]); return 1;
             default: abort();
@@ -95,6 +221,22 @@ int parse_arguments(int argc, char *argv[], chip8_config *config) {
         fprintf(stderr, "Error: --step and --cycles options cannot be used together.\n");
         return 1;
     }
+    if (config->step_mode && config->turbo) {
+        fprintf(stderr, "Error: --step and --turbo options cannot be used together.\n");
+        return 1;
+    }
+    if (config->step_mode && config->rewind_seconds > 0) {
+        fprintf(stderr, "Error: --step and --rewind options cannot be used together.\n");
+        return 1;
+    }
+    if (config->record_path && (config->rewind_seconds > 0 || config->load_state_path)) {
+        fprintf(stderr, "Error: --record replays from power-on and cannot be combined with --rewind or --load-state.\n");
+        return 1;
+    }
+    if (config->record_path && config->replay_path) {
+        fprintf(stderr, "Error: --record and --replay options cannot be used together.\n");
+        return 1;
+    }
     if (optind >= argc) {
         fprintf(stderr, "Error: Missing required ROM path argument.\n");
         print_usage(argv[0]);
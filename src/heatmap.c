@@ -0,0 +1,83 @@
+#include "heatmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(heatmap_file_header_t) == 16, "heatmap_file_header_t must not contain padding");
+
+chip8_heatmap_t* heatmap_open(const char* path) {
+    chip8_heatmap_t* heatmap = calloc(1, sizeof(*heatmap));
+    if (heatmap)
+        heatmap->path = malloc(strlen(path) + 1);
+    if (!heatmap || !heatmap->path) {
+        fprintf(stderr, "Error: Could not allocate the memory heatmap\n");
+        free(heatmap);
+        return NULL;
+    }
+    strcpy(heatmap->path, path);
+    return heatmap;
+}
+
+// Bytes touched at least once, and how much of the program is also executed or overwritten
+static void print_summary(const chip8_heatmap_t* heatmap) {
+    unsigned executed = 0, read = 0, written = 0, modified_code = 0, code_as_data = 0;
+    for (int a = 0; a < MEMORY_SIZE; a++) {
+        bool x = heatmap->counts[HEAT_EXECUTE][a] > 0;
+        bool r = heatmap->counts[HEAT_READ][a] > 0;
+        bool w = heatmap->counts[HEAT_WRITE][a] > 0;
+        executed += x;
+        read += r;
+        written += w;
+        modified_code += x && w;
+        code_as_data += x && r;
+    }
+    printf("Heatmap written to %s: %u bytes executed, %u read, %u written; "
+           "%u executed bytes also written (self-modifying code), %u also read as data\n",
+           heatmap->path, executed, read, written, modified_code, code_as_data);
+}
+
+int heatmap_close(chip8_heatmap_t* heatmap) {
+    if (!heatmap)
+        return 0;
+    heatmap_file_header_t header = {0};
+    memcpy(header.magic, HEATMAP_MAGIC, sizeof(header.magic));
+    header.version = HEATMAP_VERSION;
+    header.kinds = HEAT_KINDS;
+    header.memory_size = MEMORY_SIZE;
+
+    int result = 1;
+    FILE* file = fopen(heatmap->path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open heatmap file %s\n", heatmap->path);
+    } else {
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(heatmap->counts, sizeof(heatmap->counts), 1, file) == 1;
+        ok = (fclose(file) == 0) && ok;
+        if (ok) {
+            print_summary(heatmap);
+            result = 0;
+        } else {
+            fprintf(stderr, "Error: Could not write heatmap file %s\n", heatmap->path);
+        }
+    }
+    free(heatmap->path);
+    free(heatmap);
+    return result;
+}
+
+void heatmap_decay(chip8_heatmap_t* heatmap, uint8_t intensity[HEAT_KINDS][MEMORY_SIZE]) {
+    for (int kind = 0; kind < HEAT_KINDS; kind++) {
+        for (int a = 0; a < MEMORY_SIZE; a++) {
+            uint64_t recent = heatmap->counts[kind][a] - heatmap->seen[kind][a];
+            heatmap->seen[kind][a] = heatmap->counts[kind][a];
+            float level = heatmap->levels[kind][a] * HEATMAP_DECAY + (float)recent;
+            heatmap->levels[kind][a] = level;
+
+            // One step per doubling: a single access shows, a tight loop does not swamp everything else
+            uint32_t bits = 0;
+            for (uint32_t v = level < 1e9f ? (uint32_t)(level + 0.5f) : 1000000000u; v; v >>= 1)
+                bits++;
+            intensity[kind][a] = bits >= 12 ? 255 : (uint8_t)(bits * 21);
+        }
+    }
+}
@@ -0,0 +1,348 @@
+#define _DEFAULT_SOURCE
+#include "jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "chip8.h"
+#include "opcodes.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+
+#define JIT_BUFFER_SIZE (1 << 20)
+#define JIT_MAX_BLOCK_INSTRUCTIONS 64
+#define JIT_MAX_INSTRUCTION_BYTES 64
+#define JIT_MAX_BLOCK_BYTES (JIT_MAX_BLOCK_INSTRUCTIONS * JIT_MAX_INSTRUCTION_BYTES + 64)
+
+typedef uint32_t (*jit_block_func_t)(chip8_t* chip8);
+
+typedef struct {
+    jit_block_func_t entry; // NULL if the block starting here is not translated
+    uint32_t length;        // instructions executed by one run of the block
+} jit_block_t;
+
+struct chip8_jit {
+    uint8_t* buffer; // RWX code buffer
+    size_t used;
+    jit_block_t blocks[MEMORY_SIZE];
+    uint8_t code_map[MEMORY_SIZE]; // 1 for every byte covered by a translated block
+};
+
+typedef struct {
+    uint8_t* p;
+} emitter_t;
+
+// x86-64 registers used by the generated code
+enum { REG_EAX = 0, REG_ECX = 1, REG_EDX = 2 };
+
+#define OFFSET_V(x)      ((int32_t)(offsetof(chip8_t, V) + (x)))
+#define OFFSET_VF        OFFSET_V(0xF)
+#define OFFSET_PC        ((int32_t)offsetof(chip8_t, pc))
+#define OFFSET_I         ((int32_t)offsetof(chip8_t, I))
+#define OFFSET_DELAY     ((int32_t)offsetof(chip8_t, delay_timer))
+#define OFFSET_SOUND     ((int32_t)offsetof(chip8_t, sound_timer))
+
+static inline void emit8(emitter_t* e, uint8_t b) { *e->p++ = b; }
+static inline void emit16(emitter_t* e, uint16_t v) { memcpy(e->p, &v, 2); e->p += 2; }
+static inline void emit32(emitter_t* e, uint32_t v) { memcpy(e->p, &v, 4); e->p += 4; }
+static inline void emit64(emitter_t* e, uint64_t v) { memcpy(e->p, &v, 8); e->p += 8; }
+
+static void emit_bytes(emitter_t* e, const uint8_t* bytes, size_t n) {
+    memcpy(e->p, bytes, n);
+    e->p += n;
+}
+#define EMIT(e, ...) do { \
+        static const uint8_t bytes_[] = { __VA_ARGS__ }; \
+        emit_bytes(e, bytes_, sizeof(bytes_)); \
+    } while (0)
+
+// ModRM for [rbx + disp32] with the given reg field; rbx always holds the chip8_t pointer
+static inline void emit_mem(emitter_t* e, uint8_t reg, int32_t disp) {
+    emit8(e, 0x80 | (reg << 3) | 0x3);
+    emit32(e, (uint32_t)disp);
+}
+
+static void emit_load8(emitter_t* e, uint8_t reg, int32_t disp) {   // movzx r32, byte [rbx+disp]
+    EMIT(e, 0x0F, 0xB6);
+    emit_mem(e, reg, disp);
+}
+
+static void emit_store8(emitter_t* e, uint8_t reg, int32_t disp) {  // mov byte [rbx+disp], r8
+    emit8(e, 0x88);
+    emit_mem(e, reg, disp);
+}
+
+static void emit_store8_imm(emitter_t* e, int32_t disp, uint8_t imm) {  // mov byte [rbx+disp], imm8
+    emit8(e, 0xC6);
+    emit_mem(e, 0, disp);
+    emit8(e, imm);
+}
+
+static void emit_add8_imm(emitter_t* e, int32_t disp, uint8_t imm) {    // add byte [rbx+disp], imm8
+    emit8(e, 0x80);
+    emit_mem(e, 0, disp);
+    emit8(e, imm);
+}
+
+static void emit_store16_imm(emitter_t* e, int32_t disp, uint16_t imm) { // mov word [rbx+disp], imm16
+    EMIT(e, 0x66, 0xC7);
+    emit_mem(e, 0, disp);
+    emit16(e, imm);
+}
+
+static void emit_store16(emitter_t* e, uint8_t reg, int32_t disp) {     // mov word [rbx+disp], r16
+    EMIT(e, 0x66, 0x89);
+    emit_mem(e, reg, disp);
+}
+
+static void emit_add16(emitter_t* e, uint8_t reg, int32_t disp) {       // add word [rbx+disp], r16
+    EMIT(e, 0x66, 0x01);
+    emit_mem(e, reg, disp);
+}
+
+static void emit_add16_imm(emitter_t* e, int32_t disp, uint8_t imm) {   // add word [rbx+disp], imm8
+    EMIT(e, 0x66, 0x83);
+    emit_mem(e, 0, disp);
+    emit8(e, imm);
+}
+
+static void emit_call_handler(emitter_t* e, opcode_func_t handler, uint16_t opcode) {
+    EMIT(e, 0x48, 0x89, 0xDF);              // mov rdi, rbx
+    emit8(e, 0xBE);                         // mov esi, imm32
+    emit32(e, opcode);
+    EMIT(e, 0x48, 0xB8);                    // mov rax, imm64
+    emit64(e, (uint64_t)(uintptr_t)handler);
+    EMIT(e, 0xFF, 0xD0);                    // call rax
+}
+
+/*
+    Emits native code for the instruction if it is one of the simple ALU /
+    register ops. Every sequence mirrors the order of reads and writes in the
+    matching op_* handler, so aliasing cases like x == 0xF behave identically.
+*/
+static bool emit_native(emitter_t* e, opcode_func_t handler, uint16_t opcode) {
+    uint8_t x = (opcode >> 8) & 0x0F;
+    uint8_t y = (opcode >> 4) & 0x0F;
+    uint8_t kk = opcode & 0xFF;
+    uint16_t nnn = opcode & 0x0FFF;
+
+    if (handler == op_6xkk) {
+        emit_store8_imm(e, OFFSET_V(x), kk);
+    } else if (handler == op_7xkk) {
+        emit_add8_imm(e, OFFSET_V(x), kk);
+    } else if (handler == op_8xy0) {
+        emit_load8(e, REG_EAX, OFFSET_V(y));
+        emit_store8(e, REG_EAX, OFFSET_V(x));
+    } else if (handler == op_8xy1 || handler == op_8xy2 || handler == op_8xy3) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_load8(e, REG_ECX, OFFSET_V(y));
+        if (handler == op_8xy1)
+            EMIT(e, 0x08, 0xC8);            // or al, cl
+        else if (handler == op_8xy2)
+            EMIT(e, 0x20, 0xC8);            // and al, cl
+        else
+            EMIT(e, 0x30, 0xC8);            // xor al, cl
+        emit_store8(e, REG_EAX, OFFSET_V(x));
+    } else if (handler == op_8xy4) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_load8(e, REG_ECX, OFFSET_V(y));
+        EMIT(e, 0x01, 0xC8);                // add eax, ecx
+        EMIT(e, 0x89, 0xC2);                // mov edx, eax
+        EMIT(e, 0xC1, 0xEA, 0x08);          // shr edx, 8
+        emit_store8(e, REG_EDX, OFFSET_VF);
+        emit_store8(e, REG_EAX, OFFSET_V(x));
+    } else if (handler == op_8xy5) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_load8(e, REG_ECX, OFFSET_V(y));
+        EMIT(e, 0x39, 0xC8);                // cmp eax, ecx
+        EMIT(e, 0x0F, 0x97, 0xC2);          // seta dl
+        emit_store8(e, REG_EDX, OFFSET_VF);
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_load8(e, REG_ECX, OFFSET_V(y));
+        EMIT(e, 0x28, 0xC8);                // sub al, cl
+        emit_store8(e, REG_EAX, OFFSET_V(x));
+    } else if (handler == op_8xy6) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        EMIT(e, 0x83, 0xE0, 0x01);          // and eax, 1
+        emit_store8(e, REG_EAX, OFFSET_VF);
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        EMIT(e, 0xD0, 0xE8);                // shr al, 1
+        emit_store8(e, REG_EAX, OFFSET_V(x));
+    } else if (handler == op_8xy7) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_load8(e, REG_ECX, OFFSET_V(y));
+        EMIT(e, 0x39, 0xC1);                // cmp ecx, eax
+        EMIT(e, 0x0F, 0x97, 0xC2);          // seta dl
+        emit_store8(e, REG_EDX, OFFSET_VF);
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_load8(e, REG_ECX, OFFSET_V(y));
+        EMIT(e, 0x28, 0xC1);                // sub cl, al
+        emit_store8(e, REG_ECX, OFFSET_V(x));
+    } else if (handler == op_8xyE) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        EMIT(e, 0xC1, 0xE8, 0x07);          // shr eax, 7
+        emit_store8(e, REG_EAX, OFFSET_VF);
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        EMIT(e, 0x00, 0xC0);                // add al, al
+        emit_store8(e, REG_EAX, OFFSET_V(x));
+    } else if (handler == op_Annn) {
+        emit_store16_imm(e, OFFSET_I, nnn);
+    } else if (handler == op_Fx07) {
+        emit_load8(e, REG_EAX, OFFSET_DELAY);
+        emit_store8(e, REG_EAX, OFFSET_V(x));
+    } else if (handler == op_Fx15) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_store8(e, REG_EAX, OFFSET_DELAY);
+    } else if (handler == op_Fx18) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_store8(e, REG_EAX, OFFSET_SOUND);
+    } else if (handler == op_Fx1E) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        emit_add16(e, REG_EAX, OFFSET_I);
+    } else if (handler == op_Fx29) {
+        emit_load8(e, REG_EAX, OFFSET_V(x));
+        EMIT(e, 0x8D, 0x44, 0x80, FONT_START_ADDRESS); // lea eax, [rax + rax*4 + FONT_START_ADDRESS]
+        emit_store16(e, REG_EAX, OFFSET_I);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Handlers that neither touch the PC nor store to memory can be called from the middle of a block
+static bool is_inline_helper(opcode_func_t handler) {
+    return handler == op_00E0 || handler == op_Cxkk || handler == op_Dxyn
+        || handler == op_Fx65 || handler == op_Fx65_legacy;
+}
+
+static void jit_flush(chip8_jit_t* jit) {
+    jit->used = 0;
+    memset(jit->blocks, 0, sizeof(jit->blocks));
+    memset(jit->code_map, 0, sizeof(jit->code_map));
+}
+
+static jit_block_t* jit_compile(chip8_jit_t* jit, const chip8_t* chip8, uint16_t start) {
+    if (jit->used + JIT_MAX_BLOCK_BYTES > JIT_BUFFER_SIZE)
+        jit_flush(jit);
+
+    uint8_t* code = jit->buffer + jit->used;
+    emitter_t e = { code };
+
+    EMIT(&e, 0x53);                         // push rbx (also realigns the stack for calls)
+    EMIT(&e, 0x48, 0x89, 0xFB);             // mov rbx, rdi
+
+    uint16_t address = start;
+    uint32_t length = 0;
+    bool terminated = false;
+    while (length < JIT_MAX_BLOCK_INSTRUCTIONS && address < MEMORY_SIZE - 1) {
+        uint16_t opcode = (chip8->memory[address] << 8) | chip8->memory[address + 1];
+        opcode_func_t handler = chip8_resolve_handler(chip8, opcode);
+
+        if (!emit_native(&e, handler, opcode)) {
+            if (!is_inline_helper(handler)) {
+                // Block terminator: run the reference handler with the PC it expects
+                emit_store16_imm(&e, OFFSET_PC, address);
+                emit_call_handler(&e, handler, opcode);
+                EMIT(&e, 0x84, 0xC0);       // test al, al
+                EMIT(&e, 0x75, 0x08);       // jnz over the PC increment
+                emit_add16_imm(&e, OFFSET_PC, 2);
+                terminated = true;
+            } else {
+                emit_call_handler(&e, handler, opcode);
+            }
+        }
+
+        jit->code_map[address] = 1;
+        jit->code_map[address + 1] = 1;
+        address += 2;
+        length++;
+        if (terminated)
+            break;
+    }
+    if (length == 0)
+        return NULL;
+    if (!terminated)
+        emit_store16_imm(&e, OFFSET_PC, address);
+
+    emit8(&e, 0xB8);                        // mov eax, length
+    emit32(&e, length);
+    EMIT(&e, 0x5B, 0xC3);                   // pop rbx; ret
+
+    jit->used += (size_t)(e.p - code);
+    jit_block_t* block = &jit->blocks[start];
+    block->entry = (jit_block_func_t)(void*)code;
+    block->length = length;
+    return block;
+}
+
+chip8_jit_t* jit_create(void) {
+    chip8_jit_t* jit = calloc(1, sizeof(chip8_jit_t));
+    if (!jit)
+        return NULL;
+    jit->buffer = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (jit->buffer == MAP_FAILED) {
+        fprintf(stderr, "JIT: could not map executable memory, using the interpreter\n");
+        free(jit);
+        return NULL;
+    }
+    return jit;
+}
+
+void jit_destroy(chip8_jit_t* jit) {
+    if (!jit)
+        return;
+    munmap(jit->buffer, JIT_BUFFER_SIZE);
+    free(jit);
+}
+
+uint32_t jit_run_block(chip8_jit_t* jit, chip8_t* chip8, uint32_t budget) {
+    if (chip8->pc >= MEMORY_SIZE - 1)
+        return 0;
+    jit_block_t* block = &jit->blocks[chip8->pc];
+    if (!block->entry && !jit_compile(jit, chip8, chip8->pc))
+        return 0;
+    if (block->length > budget)
+        return 0;
+    return block->entry(chip8);
+}
+
+void jit_invalidate(chip8_jit_t* jit, uint16_t address, uint16_t length) {
+    uint32_t end = (uint32_t)address + length;
+    if (end > MEMORY_SIZE)
+        end = MEMORY_SIZE;
+    for (uint32_t a = address; a < end; a++) {
+        if (jit->code_map[a]) {
+            // Self-modifying code is rare, so simply drop every translation
+            jit_flush(jit);
+            return;
+        }
+    }
+}
+
+#else // Not x86-64: the JIT is unavailable and chip8_run_cycles interprets everything
+
+chip8_jit_t* jit_create(void) {
+    fprintf(stderr, "JIT: not supported on this platform, using the interpreter\n");
+    return NULL;
+}
+
+void jit_destroy(chip8_jit_t* jit) {
+    (void)jit;
+}
+
+uint32_t jit_run_block(chip8_jit_t* jit, chip8_t* chip8, uint32_t budget) {
+    (void)jit;
+    (void)chip8;
+    (void)budget;
+    return 0;
+}
+
+void jit_invalidate(chip8_jit_t* jit, uint16_t address, uint16_t length) {
+    (void)jit;
+    (void)address;
+    (void)length;
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <string.h>
+#include "lanes.h"
+#include "opcodes.h"
+
+/*
+    The kernels below are plain loops over CHIP8_LANES with a fixed trip
+    count and no branches on lane data, written so GCC vectorises them
+    (SSE2 on any x86-64, AVX2 with -march=haswell or newer). Masks are
+    0xFF/0x00 per lane, and every statement of a reference handler becomes
+    one masked loop in the same order, so aliasing cases such as x == 0xF
+    behave exactly like the scalar core.
+*/
+
+#define LANE_LOOP(l) for (int l = 0; l < CHIP8_LANES; l++)
+
+static inline uint8_t blend8(uint8_t mask, uint8_t value, uint8_t old) {
+    return (value & mask) | (old & ~mask);
+}
+
+static inline uint16_t widen(uint8_t mask) {
+    return (uint16_t)(int16_t)(int8_t)mask;
+}
+
+static inline uint16_t blend16(uint8_t mask, uint16_t value, uint16_t old) {
+    return (value & widen(mask)) | (old & ~widen(mask));
+}
+
+// Copies lane l's registers into its chip8_t, so reference handlers can run on it
+static void lane_store(chip8_lanes_t* lanes, uint32_t l) {
+    chip8_t* chip8 = lanes->lane[l];
+    for (int r = 0; r < NUM_REGISTERS; r++)
+        chip8->V[r] = lanes->V[r][l];
+    chip8->pc = lanes->pc[l];
+    chip8->I = lanes->I[l];
+    chip8->delay_timer = lanes->delay_timer[l];
+    chip8->sound_timer = lanes->sound_timer[l];
+}
+
+static void lane_load(chip8_lanes_t* lanes, uint32_t l) {
+    const chip8_t* chip8 = lanes->lane[l];
+    for (int r = 0; r < NUM_REGISTERS; r++)
+        lanes->V[r][l] = chip8->V[r];
+    lanes->pc[l] = chip8->pc;
+    lanes->I[l] = chip8->I;
+    lanes->delay_timer[l] = chip8->delay_timer;
+    lanes->sound_timer[l] = chip8->sound_timer;
+}
+
+int chip8_lanes_init(chip8_lanes_t* lanes, chip8_t* const machines[], uint32_t count) {
+    if (count == 0 || count > CHIP8_LANES) {
+        fprintf(stderr, "Error: Lane count must be between 1 and %d, got %u\n", CHIP8_LANES, count);
+        return 1;
+    }
+    memset(lanes, 0, sizeof(*lanes));
+    for (uint32_t l = 0; l < count; l++) {
+        if (machines[l]->clock_rate != machines[0]->clock_rate
+            || machines[l]->cycles != machines[0]->cycles
+            || machines[l]->timer_ticks != machines[0]->timer_ticks) {
+            fprintf(stderr, "Error: Lane %u is not in step with lane 0 (clock rate, cycles or timer ticks differ)\n", l);
+            return 1;
+        }
+        lanes->lane[l] = machines[l];
+        lanes->active[l] = 0xFF;
+        lane_load(lanes, l);
+    }
+    lanes->count = count;
+    lanes->clock_rate = machines[0]->clock_rate;
+    lanes->cycles = machines[0]->cycles;
+    lanes->timer_ticks = machines[0]->timer_ticks;
+    return 0;
+}
+
+void chip8_lanes_sync(chip8_lanes_t* lanes) {
+    for (uint32_t l = 0; l < lanes->count; l++) {
+        lane_store(lanes, l);
+        lanes->lane[l]->cycles = lanes->cycles;
+        lanes->lane[l]->timer_ticks = lanes->timer_ticks;
+    }
+}
+
+// Opcodes without a kernel: run the reference handler on each lane of the group
+static void lanes_fallback(chip8_lanes_t* lanes, uint16_t opcode, const uint8_t mask[CHIP8_LANES]) {
+    for (uint32_t l = 0; l < lanes->count; l++) {
+        if (!mask[l])
+            continue;
+        chip8_t* chip8 = lanes->lane[l];
+        lane_store(lanes, l);
+        if (!chip8_resolve_handler(chip8, opcode)(chip8, opcode))
+            chip8->pc += 2;
+        lane_load(lanes, l);
+    }
+}
+
+// Executes opcode on the lanes selected by mask
+static void lanes_execute(chip8_lanes_t* lanes, uint16_t opcode, const uint8_t mask[CHIP8_LANES]) {
+    uint8_t x = (opcode >> 8) & 0x0F;
+    uint8_t y = (opcode >> 4) & 0x0F;
+    uint8_t kk = opcode & 0xFF;
+    uint16_t nnn = opcode & 0x0FFF;
+    uint8_t* Vx = lanes->V[x];
+    uint8_t* Vy = lanes->V[y];
+    uint8_t* VF = lanes->V[0xF];
+    uint16_t* pc = lanes->pc;
+
+    switch (opcode >> 12) {
+        // PC-changing opcodes update pc themselves and return
+        case 0x1: LANE_LOOP(l) pc[l] = blend16(mask[l], nnn, pc[l]); return;
+        case 0x3: LANE_LOOP(l) pc[l] += widen(mask[l]) & (Vx[l] == kk ? 4 : 2); return;
+        case 0x4: LANE_LOOP(l) pc[l] += widen(mask[l]) & (Vx[l] != kk ? 4 : 2); return;
+        case 0x5: LANE_LOOP(l) pc[l] += widen(mask[l]) & (Vx[l] == Vy[l] ? 4 : 2); return;
+        case 0x9: LANE_LOOP(l) pc[l] += widen(mask[l]) & (Vx[l] != Vy[l] ? 4 : 2); return;
+
+        case 0x6: LANE_LOOP(l) Vx[l] = blend8(mask[l], kk, Vx[l]); break;
+        case 0x7: LANE_LOOP(l) Vx[l] += kk & mask[l]; break;
+        case 0x8:
+            switch (opcode & 0x0F) {
+                case 0x0: LANE_LOOP(l) Vx[l] = blend8(mask[l], Vy[l], Vx[l]); break;
+                case 0x1: LANE_LOOP(l) Vx[l] |= Vy[l] & mask[l]; break;
+                case 0x2: LANE_LOOP(l) Vx[l] &= Vy[l] | ~mask[l]; break;
+                case 0x3: LANE_LOOP(l) Vx[l] ^= Vy[l] & mask[l]; break;
+                case 0x4: {
+                    uint8_t sum[CHIP8_LANES], carry[CHIP8_LANES];
+                    LANE_LOOP(l) {
+                        sum[l] = (uint8_t)(Vx[l] + Vy[l]);
+                        carry[l] = (Vx[l] + Vy[l]) > 255;
+                    }
+                    LANE_LOOP(l) VF[l] = blend8(mask[l], carry[l], VF[l]);
+                    LANE_LOOP(l) Vx[l] = blend8(mask[l], sum[l], Vx[l]);
+                    break;
+                }
+                case 0x5:
+                    LANE_LOOP(l) VF[l] = blend8(mask[l], Vx[l] > Vy[l], VF[l]);
+                    LANE_LOOP(l) Vx[l] = blend8(mask[l], Vx[l] - Vy[l], Vx[l]);
+                    break;
+                case 0x6:
+                    LANE_LOOP(l) VF[l] = blend8(mask[l], Vx[l] & 1, VF[l]);
+                    LANE_LOOP(l) Vx[l] = blend8(mask[l], Vx[l] >> 1, Vx[l]);
+                    break;
+                case 0x7:
+                    LANE_LOOP(l) VF[l] = blend8(mask[l], Vy[l] > Vx[l], VF[l]);
+                    LANE_LOOP(l) Vx[l] = blend8(mask[l], Vy[l] - Vx[l], Vx[l]);
+                    break;
+                case 0xE:
+                    LANE_LOOP(l) VF[l] = blend8(mask[l], (Vx[l] & 0x80) >> 7, VF[l]);
+                    LANE_LOOP(l) Vx[l] = blend8(mask[l], Vx[l] << 1, Vx[l]);
+                    break;
+                default:
+                    lanes_fallback(lanes, opcode, mask);
+                    return;
+            }
+            break;
+        case 0xA: LANE_LOOP(l) lanes->I[l] = blend16(mask[l], nnn, lanes->I[l]); break;
+        case 0xF:
+            switch (kk) {
+                case 0x07: LANE_LOOP(l) Vx[l] = blend8(mask[l], lanes->delay_timer[l], Vx[l]); break;
+                case 0x15: LANE_LOOP(l) lanes->delay_timer[l] = blend8(mask[l], Vx[l], lanes->delay_timer[l]); break;
+                case 0x18: LANE_LOOP(l) lanes->sound_timer[l] = blend8(mask[l], Vx[l], lanes->sound_timer[l]); break;
+                case 0x1E: LANE_LOOP(l) lanes->I[l] += widen(mask[l]) & Vx[l]; break;
+                case 0x29:
+                    LANE_LOOP(l) lanes->I[l] = blend16(mask[l], FONT_START_ADDRESS + Vx[l] * 5, lanes->I[l]);
+                    break;
+                default:
+                    lanes_fallback(lanes, opcode, mask);
+                    return;
+            }
+            break;
+        default:
+            lanes_fallback(lanes, opcode, mask);
+            return;
+    }
+    LANE_LOOP(l) pc[l] += widen(mask[l]) & 2;
+}
+
+// One instruction on every active lane. Lanes that fetched the same opcode run as one group.
+static void lanes_step(chip8_lanes_t* lanes) {
+    uint16_t opcode[CHIP8_LANES] = {0};
+    for (uint32_t l = 0; l < lanes->count; l++) {
+        const uint8_t* memory = lanes->lane[l]->memory;
+        uint16_t pc = lanes->pc[l] &= MEMORY_ADDRESS_MASK;
+        opcode[l] = (memory[pc] << 8) | memory[(pc + 1) & MEMORY_ADDRESS_MASK];
+    }
+
+    _Alignas(32) uint8_t pending[CHIP8_LANES];
+    memcpy(pending, lanes->active, sizeof(pending));
+    for (uint32_t first = 0; first < lanes->count; first++) {
+        if (!pending[first])
+            continue;
+        uint16_t group_opcode = opcode[first];
+        _Alignas(32) uint8_t mask[CHIP8_LANES];
+        LANE_LOOP(l) {
+            mask[l] = pending[l] & (uint8_t)-(opcode[l] == group_opcode);
+            pending[l] &= ~mask[l];
+        }
+        lanes_execute(lanes, group_opcode, mask);
+    }
+}
+
+// Same schedule as chip8_cycles_until_tick, for the shared lane clock
+static uint64_t lanes_cycles_until_tick(const chip8_lanes_t* lanes) {
+    uint64_t next_tick = ((lanes->timer_ticks + 1) * lanes->clock_rate + (TIMER_RATE - 1)) / TIMER_RATE;
+    return (lanes->cycles >= next_tick) ? 0 : next_tick - lanes->cycles;
+}
+
+void chip8_lanes_run(chip8_lanes_t* lanes, uint64_t cycles) {
+    while (cycles > 0) {
+        uint64_t run = lanes_cycles_until_tick(lanes);
+        if (run > cycles)
+            run = cycles;
+        for (uint64_t i = 0; i < run; i++)
+            lanes_step(lanes);
+        lanes->cycles += run;
+        cycles -= run;
+
+        while (lanes_cycles_until_tick(lanes) == 0) {
+            LANE_LOOP(l) {
+                lanes->delay_timer[l] -= lanes->delay_timer[l] != 0;
+                lanes->sound_timer[l] -= lanes->sound_timer[l] != 0;
+            }
+            lanes->timer_ticks++;
+        }
+    }
+}
@@ -1,172 +1,600 @@
 #include <stdio.h>
 #include <stdint.h> 
-#include <SDL2/SDL.h>
+#include <string.h>
 #include <stdbool.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include "chip8.h"
 #include "config.h"
 #include "debug.h"
+#include "platform.h"
+#include "snapshot.h"
+#include "rewind.h"
+#include "movie.h"
+#include "stats.h"
+#include "triple_buffer.h"
+#include "audio.h"
 
-const int FPS = 60;
-const int FRAME_DELAY = 1000 / FPS;
-const int INSTRUCTIONS_PER_FRAME = 700 / FPS;
+#define FRAME_PERIOD_NS (1000000000ull / TIMER_RATE)
+#define MAX_CATCH_UP_FRAMES 4
+#define PRESENT_IDLE_NS 1000000ull // presentation thread poll interval while no new frame is ready
 
-void render_graphics(SDL_Renderer *renderer, const uint8_t display[], uint8_t scale);
-void handle_input(chip8_t* chip8, bool* running);
+/*
+    Host time accounting, for turbo mode and --stats. Each phase is timed
+    separately. The emulation thread runs emulate, timers, sync (taking
+    input and commands, publishing the frame) and sleep; the presentation
+    thread runs input (polling the host), render and memory. Phases before
+    PHASE_SLEEP are the busy part of an emulated frame. In turbo mode one
+    window is reported and reset every second, the other covers the whole
+    run and is printed as the final summary.
+*/
+typedef enum {
+    PHASE_EMULATE,
+    PHASE_TIMERS,
+    PHASE_SYNC,
+    PHASE_SLEEP,
+    PHASE_INPUT,
+    PHASE_RENDER,
+    PHASE_MEMORY,
+    PHASE_COUNT
+} host_phase_t;
 
-#define DUMP_FILENAME "dump.txt" 
+static const char* const phase_names[PHASE_COUNT] = {
+    "emulate", "timers", "sync", "sleep", "input", "render", "memory"
+};
 
-int main(int argc, char *argv[]) {
-    chip8_config config;
-    if (parse_arguments(argc, argv, &config) != 0)
-        return 1;
-    
-    printf("\nPress Enter to continue...");
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF) { };
+typedef struct {
+    uint64_t phase_ns[PHASE_COUNT];
+    uint64_t start_ns;
+    uint64_t start_cycles;
+    uint64_t start_ticks;
+    uint64_t start_presents;
+    uint64_t start_idle;
+} perf_window_t;
 
-    chip8_t chip8;
-    chip8_initialize(&chip8, &config);
-    chip8_load_rom(&chip8, config.rom_path);
+static void perf_reset(perf_window_t* perf, const chip8_t* chip8, uint64_t presents, uint64_t now) {
+    memset(perf, 0, sizeof(*perf));
+    perf->start_ns = now;
+    perf->start_cycles = chip8->cycles;
+    perf->start_ticks = chip8->timer_ticks;
+    perf->start_presents = presents;
+    perf->start_idle = chip8->idle_cycles;
+}
 
-    const int SCREEN_WIDTH = DISPLAY_WIDTH * config.scale_factor;
-    const int SCREEN_HEIGHT = DISPLAY_HEIGHT * config.scale_factor;
+typedef struct {
+    perf_window_t window;               // reported and reset every second
+    perf_window_t total;                // the whole run
+    uint64_t iteration_ns[PHASE_COUNT]; // the current loop iteration
+} host_timing_t;
 
-    // SDL init
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        fprintf(stderr, "Could not initialize SDL: %s\n", SDL_GetError());
-        return 1;
+static void timing_add(host_timing_t* timing, host_phase_t phase, uint64_t ns) {
+    timing->window.phase_ns[phase] += ns;
+    timing->total.phase_ns[phase] += ns;
+    timing->iteration_ns[phase] += ns;
+}
+
+static void perf_report(const char* label, const perf_window_t* perf, const chip8_t* chip8, uint64_t presents, uint64_t now) {
+    double seconds = (now - perf->start_ns) / 1e9;
+    if (seconds <= 0)
+        return;
+    uint64_t instructions = chip8->cycles - perf->start_cycles;
+    uint64_t frames = chip8->timer_ticks - perf->start_ticks;
+    uint64_t idle = chip8->idle_cycles - perf->start_idle;
+    uint64_t busy_ns = 0;
+    for (int i = 0; i < PHASE_SLEEP; i++)
+        busy_ns += perf->phase_ns[i];
+
+    printf("[%s] %8.2f MIPS (%5.1f%% idle) | %9.0f frames/s | %5.0f presents/s | %8.2f us/frame |",
+           label, instructions / seconds / 1e6, instructions ? 100.0 * idle / instructions : 0.0,
+           frames / seconds, (presents - perf->start_presents) / seconds,
+           frames ? (now - perf->start_ns) / 1e3 / frames : 0.0);
+    for (int i = 0; i < PHASE_SLEEP; i++)
+        printf(" %s %5.1f%%", phase_names[i], busy_ns ? 100.0 * perf->phase_ns[i] / busy_ns : 0.0);
+    printf("\n");
+}
+
+// Runs cycles instructions, then delivers every 60 Hz timer tick that became due.
+// Time spent in each half is added to timing when it is given.
+static void emulate(chip8_t* chip8, uint32_t cycles, host_timing_t* timing) {
+    if (!timing) {
+        chip8_run_cycles(chip8, cycles);
+        while (chip8_cycles_until_tick(chip8) == 0)
+            update_timers(chip8);
+        return;
     }
+    uint64_t t0 = platform_time_ns();
+    chip8_run_cycles(chip8, cycles);
+    uint64_t t1 = platform_time_ns();
+    while (chip8_cycles_until_tick(chip8) == 0)
+        update_timers(chip8);
+    uint64_t t2 = platform_time_ns();
+    timing_add(timing, PHASE_EMULATE, t1 - t0);
+    timing_add(timing, PHASE_TIMERS, t2 - t1);
+}
 
-    SDL_Window* window = SDL_CreateWindow("CHIP-8 Emulator", 
-                                           SDL_WINDOWPOS_UNDEFINED, 
-                                           SDL_WINDOWPOS_UNDEFINED, 
-                                           SCREEN_WIDTH, 
-                                           SCREEN_HEIGHT, 
-                                           SDL_WINDOW_SHOWN);
-    if (!window) {
-        fprintf(stderr, "Could not create window: %s\n", SDL_GetError());
-        return 1;
-    }   
+/*
+    State shared by the two host threads. The emulation thread owns the
+    machine and publishes finished frames through the triple buffer; the
+    presentation thread owns the platform, presents the newest frame at the
+    display's own rate and hands input back through atomics. Neither ever
+    waits for the other.
+*/
+typedef struct {
+    triple_buffer_t frames;        // emulation -> presentation
+    atomic_uint keys;              // keypad, one bit per key
+    atomic_uint held_commands;     // PLATFORM_CMD_REWIND, for as long as it is held
+    atomic_uint pending_commands;  // other PLATFORM_CMD_* not yet handled
+    atomic_bool memory_wanted;     // the visualiser is due a refresh
+    atomic_bool quit;              // the user closed the window
+    atomic_bool finished;          // the emulation thread has stopped
+    atomic_uint_fast64_t presents;
+} host_link_t;
+
+typedef struct {
+    chip8_t* chip8;
+    chip8_config* config;
+    platform_t* platform;          // for audio only, which may be used from any thread
+    rewind_buffer_t* rewind;
+    movie_recorder_t* recorder;
+    stats_exporter_t* stats;
+    host_link_t* link;
+} emulation_t;
+
+// Instructions to run this frame: up to the next timer tick, clipped to --cycles
+static uint32_t frame_cycles(const chip8_t* chip8, const chip8_config* config) {
+    uint64_t cycles = chip8_cycles_until_tick(chip8);
+    if (config->cycles_to_run > 0 && (uint64_t)config->cycles_to_run - chip8->cycles < cycles)
+        cycles = (uint64_t)config->cycles_to_run - chip8->cycles;
+    return (uint32_t)cycles;
+}
+
+// F5/F9: save or restore config->state_path. Returns true if the machine state was replaced.
+static bool handle_state_commands(chip8_t* chip8, const chip8_config* config, uint32_t commands) {
+    if (commands & PLATFORM_CMD_SAVE_STATE) {
+        uint64_t t0 = platform_time_ns();
+        if (chip8_save_state(chip8, config->state_path) == 0)
+            platform_log(LOG_INFO, "Saved state at cycle %" PRIu64 " to %s (%.1f us)\n",
+                         chip8->cycles, config->state_path, (platform_time_ns() - t0) / 1e3);
+    }
+    if (commands & PLATFORM_CMD_LOAD_STATE) {
+        uint64_t t0 = platform_time_ns();
+        if (chip8_load_state(chip8, config->state_path) == 0) {
+            platform_log(LOG_INFO, "Loaded state at cycle %" PRIu64 " from %s (%.1f us)\n",
+                         chip8->cycles, config->state_path, (platform_time_ns() - t0) / 1e3);
+            chip8->draw_flag = true;
+            return true;
+        }
+    }
+    return false;
+}
 
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (!renderer) {
-        fprintf(stderr, "Could not create renderer: %s\n", SDL_GetError());
+// Steps back one frame in the rewind history. Keys held right now win over the recorded keypad.
+static bool rewind_frame(rewind_buffer_t* rewind, chip8_t* chip8) {
+    uint8_t keypad[NUM_KEYS];
+    memcpy(keypad, chip8->keypad, sizeof(keypad));
+    bool restored = rewind_step_back(rewind, chip8) == 0;
+    memcpy(chip8->keypad, keypad, sizeof(keypad));
+    if (restored)
+        chip8->draw_flag = true;
+    return restored;
+}
+
+// --replay: runs a recorded movie headless and uncapped, then checks the final display
+static int replay_movie(chip8_config* config) {
+    movie_t movie;
+    if (movie_load(config->replay_path, &movie) != 0)
         return 1;
+    config->clock_rate = movie.header.clock_rate;
+    config->seed = movie.header.seed;
+    config->legacy_mode = (movie.header.quirks & CHIP8_QUIRK_LEGACY_LOAD_STORE) != 0;
+
+    // chip8_t is large with the predecoded core, keep it off the stack
+    static chip8_t chip8;
+    chip8_initialize(&chip8, config);
+    chip8_load_rom(&chip8, config->rom_path);
+    if (movie_rom_hash(&chip8) != movie.header.rom_hash)
+        platform_log(LOG_ERROR, "%s was not recorded with %s, replaying anyway\n", config->replay_path, config->rom_path);
+
+    uint64_t t0 = platform_time_ns();
+    int result = movie_replay(&chip8, &movie);
+    double seconds = (platform_time_ns() - t0) / 1e9;
+    printf("Replayed %" PRIu64 " key events over %" PRIu64 " cycles in %.3f s (%.2f MIPS)\n",
+           movie.header.event_count, chip8.cycles, seconds, seconds > 0 ? chip8.cycles / seconds / 1e6 : 0.0);
+    printf("Display hash %016" PRIx64 ": %s (recorded %016" PRIx64 ")\n", chip8_display_hash(chip8.display),
+           result == 0 ? "MATCH" : "MISMATCH", movie.header.final_display_hash);
+
+    movie_free(&movie);
+    chip8_shutdown(&chip8);
+    return result == 0 ? 0 : 2;
+}
+
+/*
+    Queues frames 60 Hz frames of the buzzer. Each frame is stretched or
+    shortened by a sample to steer the queue towards target samples, which
+    absorbs the drift between the host clock that pacing uses and the audio
+    device's clock. One device buffer is the least target that survives the
+    device taking a whole buffer just before the next frame is queued.
+    Frames that find the queue a whole frame over target (turbo mode) are
+    skipped without rendering.
+*/
+static void queue_audio(platform_t* platform, audio_tone_t* wave, uint32_t target, uint64_t frames, bool on) {
+    int16_t samples[AUDIO_MAX_FRAME_SAMPLES];
+    for (uint64_t f = 0; f < frames && f < MAX_CATCH_UP_FRAMES; f++) {
+        uint32_t length = audio_tone_frame_length(wave);
+        uint32_t queued = platform_audio_queued(platform);
+        if (queued >= target + length)
+            continue;
+        // An empty queue (start-up, or after a stall) is topped up with silence first
+        for (uint32_t missing = queued == 0 ? target : 0; missing > 0; ) {
+            uint32_t chunk = missing < AUDIO_MAX_FRAME_SAMPLES ? missing : AUDIO_MAX_FRAME_SAMPLES;
+            memset(samples, 0, chunk * sizeof(*samples));
+            platform_audio_write(platform, samples, chunk);
+            missing -= chunk;
+            queued += chunk;
+        }
+        if (queued < target)
+            length++;
+        else if (queued > target)
+            length--;
+        audio_tone_render(wave, on, samples, length);
+        platform_audio_write(platform, samples, length);
     }
-	
-	// Create memory visualiser window
-	// TODO: Make this work based on -v flag
-	MemoryVisualiser_t mem_vis;
-	int main_x, main_y, main_w, main_h;
-	SDL_GetWindowPosition(window, &main_x, &main_y);
-	SDL_GetWindowSize(window, &main_w, &main_h);
-	if (!memory_visualiser_init(&mem_vis, (main_x + main_w)))
-		printf("Memory visualiser initialisastion failed.\n");
-
-    uint32_t last_timer_update = SDL_GetTicks();
+}
+
+/*
+    Publishes this frame's display, tone and, when the visualiser asked for
+    it, memory and heat. Frames that would show the presentation thread
+    nothing new are not published at all. Returns true if one was.
+*/
+static bool publish_frame(host_link_t* link, chip8_t* chip8, bool* tone, uint64_t* memory_sequence) {
+    // A plain load first: the exchange writes the shared line, which would bounce it every frame
+    bool memory = atomic_load_explicit(&link->memory_wanted, memory_order_relaxed)
+        && atomic_exchange_explicit(&link->memory_wanted, false, memory_order_relaxed);
+    if (!chip8->draw_flag && (chip8->sound_timer > 0) == *tone && !memory)
+        return false;
+
+    host_frame_t* frame = triple_buffer_back(&link->frames);
+    memcpy(frame->display, chip8->display, sizeof(frame->display));
+    frame->tone = *tone = chip8->sound_timer > 0;
+    frame->has_memory = memory;
+    if (frame->has_memory) {
+        memcpy(frame->memory, chip8->memory, sizeof(frame->memory));
+        frame->memory_sequence = ++*memory_sequence;
+        frame->memory_dirty = chip8->memory_dirty;
+        chip8->memory_dirty = 0;
+        frame->has_heat = chip8->heatmap != NULL;
+        if (frame->has_heat)
+            heatmap_decay(chip8->heatmap, frame->heat);
+    }
+    chip8->draw_flag = false;
+    triple_buffer_publish(&link->frames);
+    return true;
+}
+
+// The emulation thread: paces 60 Hz frames, applies input and commands, publishes each frame
+static void* run_emulation(void* arg) {
+    emulation_t* emulation = arg;
+    chip8_t* chip8 = emulation->chip8;
+    chip8_config* config = emulation->config;
+    rewind_buffer_t* rewind = emulation->rewind;
+    movie_recorder_t* recorder = emulation->recorder;
+    stats_exporter_t* stats = emulation->stats;
+    host_link_t* link = emulation->link;
+
+    // Buzzer samples for every emulated frame, if the platform has an audio device
+    audio_tone_t wave;
+    uint32_t audio_rate = platform_audio_rate(emulation->platform);
+    uint32_t audio_buffer = platform_audio_buffer(emulation->platform);
+    if (audio_rate)
+        audio_tone_init(&wave, audio_rate, AUDIO_TONE_HZ);
+
     bool running = true;
-	int64_t cycles_elapsed = 0;
-	
-    // --- Main emulation loop --- 
-    while (running) {
-        uint32_t frame_start = SDL_GetTicks();
+    uint64_t next_frame_ns = platform_time_ns();
+    uint64_t memory_sequence = 0;
+    bool tone = false;
+
+    // Turbo mode: no frame pacing, optional present skipping and per-second reports
+    host_timing_t host_timing;
+    uint64_t presents = atomic_load(&link->presents);
+    perf_reset(&host_timing.window, chip8, presents, next_frame_ns);
+    perf_reset(&host_timing.total, chip8, presents, next_frame_ns);
+    host_timing_t* timing = (config->turbo || stats) ? &host_timing : NULL;
+    uint64_t turbo_frames = 0;
+    stats_export(stats, next_frame_ns, chip8->cycles, false);
 
-		render_memory(mem_vis.renderer, chip8.memory);
+    while (running && !atomic_load(&link->quit)) {
 		int sc;
-		if (config.step_mode || config.cycles_to_run) cycles_elapsed++;
-		if (config.step_mode) {
-			printf("Emulation cycle: %15lu | Press <Enter> to continue. Type D to dump state and exit...\n", cycles_elapsed);
+		if (config->step_mode) {
+			printf("Emulation cycle: %15lu | Press <Enter> to continue. Type D to dump state and exit...\n", chip8->cycles);
 			while ((sc = getchar()) != '\n' && sc != EOF) {
 				if (sc == 'D' || sc == 'd') {
-					if(dump_state(&chip8, &config, DUMP_FILENAME))
+					if(dump_state(chip8, config, config->state_path))
 						printf("Dump unsuccessful.\n");
-					printf("Exiting...\n");
-					return 0; 
+					running = false;
+					break;
 				}
 			};
+			if (!running)
+				break;
 		}
-		if (config.cycles_to_run == cycles_elapsed) {
-			printf("%ld cycles completed. Dump state before exiting? (Y/N) > ", cycles_elapsed);
-			sc = getchar();
-			if (sc == 'Y' || sc == 'y') {
-				if(dump_state(&chip8, &config, DUMP_FILENAME))
-					printf("Dump unsuccessful.\n");
-				printf("Exiting...\n");
-				return 0; 
+		// --cycles counts from power-on, so a restored state may already be past it
+		if (config->cycles_to_run > 0 && (uint64_t)config->cycles_to_run <= chip8->cycles) {
+			if (platform_interactive()) {
+				printf("%lu cycles completed. Dump state before exiting? (Y/N) > ", chip8->cycles);
+				sc = getchar();
+				if (sc == 'Y' || sc == 'y') {
+					if(dump_state(chip8, config, config->state_path))
+						printf("Dump unsuccessful.\n");
+				}
+			} else {
+				printf("%lu cycles completed.\n", chip8->cycles);
 			}
+			break;
 		}
-			
-        handle_input(&chip8, &running);
-        for (int i = 0; i < INSTRUCTIONS_PER_FRAME; i++) {
-            chip8_emulate_cycle(&chip8);
+
+        memset(host_timing.iteration_ns, 0, sizeof(host_timing.iteration_ns));
+        uint32_t late_frames = 0;
+        uint64_t t0 = platform_time_ns();
+        uint64_t cycles_before = chip8->cycles, ticks_before = chip8->timer_ticks;
+        uint8_t keys_before[NUM_KEYS];
+        memcpy(keys_before, chip8->keypad, sizeof(keys_before));
+        uint32_t keys = atomic_load_explicit(&link->keys, memory_order_relaxed);
+        for (int i = 0; i < NUM_KEYS; i++)
+            chip8->keypad[i] = (keys >> i) & 1;
+        uint32_t commands = atomic_load(&link->held_commands);
+        if (atomic_load_explicit(&link->pending_commands, memory_order_relaxed))
+            commands |= atomic_exchange(&link->pending_commands, 0);
+        if (recorder) {
+            movie_record_keys(recorder, chip8, keys_before);
+            if (commands & PLATFORM_CMD_LOAD_STATE) {
+                // The movie replays from power-on, a loaded state would break it
+                platform_log(LOG_INFO, "Loading a state is disabled while recording\n");
+                commands &= ~PLATFORM_CMD_LOAD_STATE;
+            }
+        }
+        bool restored = commands && handle_state_commands(chip8, config, commands);
+        if (restored)
+            next_frame_ns = platform_time_ns(); // the restored state starts a fresh frame
+        bool rewinding = rewind && (commands & PLATFORM_CMD_REWIND);
+        if (rewinding)
+            restored |= rewind_frame(rewind, chip8);
+        if (restored) {
+            // Turbo statistics keep counting executed instructions across the jump (modulo 2^64)
+            host_timing.window.start_cycles += chip8->cycles - cycles_before;
+            host_timing.window.start_ticks += chip8->timer_ticks - ticks_before;
+            host_timing.total.start_cycles += chip8->cycles - cycles_before;
+            host_timing.total.start_ticks += chip8->timer_ticks - ticks_before;
         }
+        uint64_t t1 = platform_time_ns();
+        if (timing)
+            timing_add(timing, PHASE_SYNC, t1 - t0);
 
-        update_timers(&chip8, &last_timer_update);
+        bool present = true;
+        if (rewinding) {
+            // Play the history backwards at 60 frames per second, even in turbo mode
+            uint64_t now = platform_time_ns();
+            next_frame_ns = (now >= next_frame_ns + FRAME_PERIOD_NS) ? now : next_frame_ns + FRAME_PERIOD_NS;
+        } else if (config->step_mode) {
+            emulate(chip8, 1, NULL);
+        } else if (config->turbo) {
+            // One emulated frame per iteration, as fast as the host allows
+            emulate(chip8, frame_cycles(chip8, config), timing);
+            present = ++turbo_frames % config->present_interval == 0;
+        } else {
+            // Emulate every 60 Hz frame that is due. After a stall, catch up at most
+            // MAX_CATCH_UP_FRAMES at once and drop the rest of the backlog.
+            // Every caught-up or dropped frame missed its deadline.
+            uint64_t now = platform_time_ns();
+            int frames = 0;
+            do {
+                emulate(chip8, frame_cycles(chip8, config), timing);
+                next_frame_ns += FRAME_PERIOD_NS;
+                frames++;
+            } while (now >= next_frame_ns && frames < MAX_CATCH_UP_FRAMES
+                     && (config->cycles_to_run <= 0 || (uint64_t)config->cycles_to_run > chip8->cycles));
+            late_frames = frames - 1;
+            if (now >= next_frame_ns + FRAME_PERIOD_NS) {
+                late_frames += (uint32_t)((now - next_frame_ns) / FRAME_PERIOD_NS);
+                next_frame_ns = now;
+            }
+        }
+        if (rewind && !rewinding)
+            rewind_push(rewind, chip8);
+        if (audio_rate) {
+            // Rewinding plays silence; a jump to a loaded state emulated no frame of its own
+            uint64_t frames = rewinding ? 1 : restored ? 0 : chip8->timer_ticks - ticks_before;
+            queue_audio(emulation->platform, &wave, audio_buffer, frames,
+                        !rewinding && chip8->sound_timer > 0);
+        }
 
-        if (chip8.draw_flag) {
-            render_graphics(renderer, chip8.display, config.scale_factor);
-            chip8.draw_flag = false;
+        // A skipped present leaves draw_flag set so the next presented frame picks it up
+        uint64_t frame_end = platform_time_ns();
+        if (present && publish_frame(link, chip8, &tone, &memory_sequence)) {
+            uint64_t published = platform_time_ns();
+            if (timing)
+                timing_add(timing, PHASE_SYNC, published - frame_end);
+            frame_end = published;
+        }
+        if (config->turbo && frame_end - host_timing.window.start_ns >= 1000000000ull) {
+            presents = atomic_load(&link->presents);
+            perf_report("turbo", &host_timing.window, chip8, presents, frame_end);
+            perf_reset(&host_timing.window, chip8, presents, frame_end);
         }
 
-        uint32_t frame_time = SDL_GetTicks() - frame_start;
-        if (frame_time < FRAME_DELAY) {
-            SDL_Delay(FRAME_DELAY - frame_time);
+        if ((!config->step_mode && !config->turbo) || rewinding) {
+            uint64_t s0 = platform_time_ns();
+            platform_sleep_until_ns(next_frame_ns);
+            if (timing)
+                timing_add(timing, PHASE_SLEEP, platform_time_ns() - s0);
+        }
+
+        if (stats) {
+            uint64_t busy_ns = 0;
+            for (int i = 0; i < PHASE_SLEEP; i++) {
+                busy_ns += host_timing.iteration_ns[i];
+                stats_record_phase(stats, i, host_timing.iteration_ns[i]);
+            }
+            stats_record_phase(stats, PHASE_SLEEP, host_timing.iteration_ns[PHASE_SLEEP]);
+            stats_record_frame(stats, busy_ns, FRAME_PERIOD_NS, late_frames);
+            stats_export(stats, platform_time_ns(), chip8->cycles, false);
         }
     }
-    
-    return 0;
+
+    if (config->turbo)
+        perf_report("total", &host_timing.total, chip8, atomic_load(&link->presents), platform_time_ns());
+    atomic_store(&link->finished, true);
+    return NULL;
 }
 
+/*
+    The presentation loop, on the thread that created the platform. Polls
+    host input and forwards it, then shows the newest published frame if
+    there is one: the display when it changed (the SDL backend waits for
+    vsync here) and the memory visualiser when its refresh is due. Runs
+    until the emulation thread stops.
+*/
+static void run_presentation(platform_t* platform, const chip8_config* config, host_link_t* link,
+                             stats_exporter_t* stats) {
+    const uint64_t mem_vis_interval_ns = 1000000000ull / config->visualiser_rate;
+    uint64_t last_mem_vis_update = 0;
+    uint64_t shown_memory_sequence = 0;
+    uint64_t shown_display[DISPLAY_HEIGHT];
+    bool shown = false;
+    uint8_t keypad[NUM_KEYS] = {0};
 
-void render_graphics(SDL_Renderer *renderer, const uint8_t display[], uint8_t scale) {
-    /*
-        1. Iterate through display array
-            - Use two for loops for simpler scaled_x and scaled_y calc
-        2. For each pixel, IF a pixel is "on" define a SDL_Rect (x, y, h=10, w=10)
-        3. Tell the renderer to draw it
-        (y * 64) + x
-    */ 
-    
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Set background color to black
-    SDL_RenderClear(renderer);
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // Set draw color to white
-
-    for (int y = 0; y < 32; y++) {
-        for (int x = 0; x < 64; x++) {
-            if (display[(y * 64) + x] == 1) {
-                SDL_Rect pixel_rect = {
-                        .x = x * scale,
-                        .y = y * scale,
-                        .w = scale,
-                        .h = scale 
-                };
-                SDL_RenderFillRect(renderer, &pixel_rect);
-            } 
-        }
-    } 
-    SDL_RenderPresent(renderer);
+    while (!atomic_load(&link->finished)) {
+        uint64_t t0 = platform_time_ns();
+        uint32_t commands;
+        if (!platform_poll_input(platform, keypad, &commands))
+            atomic_store(&link->quit, true);
+        uint32_t keys = 0;
+        for (int i = 0; i < NUM_KEYS; i++)
+            keys |= (uint32_t)(keypad[i] != 0) << i;
+        atomic_store_explicit(&link->keys, keys, memory_order_relaxed);
+        atomic_store(&link->held_commands, commands & PLATFORM_CMD_REWIND);
+        if (commands & ~PLATFORM_CMD_REWIND)
+            atomic_fetch_or(&link->pending_commands, commands & ~PLATFORM_CMD_REWIND);
+        uint64_t t1 = platform_time_ns();
+        stats_record_phase(stats, PHASE_INPUT, t1 - t0);
+
+        // Asked for again until a frame with memory arrives, the one carrying it may be overwritten
+        if (config->memory_visualiser && t1 - last_mem_vis_update >= mem_vis_interval_ns)
+            atomic_store_explicit(&link->memory_wanted, true, memory_order_relaxed);
+
+        const host_frame_t* frame = triple_buffer_acquire(&link->frames);
+        if (!frame) {
+            platform_sleep_until_ns(t1 + PRESENT_IDLE_NS);
+            continue;
+        }
+        platform_set_tone(platform, frame->tone);
+        if (!shown || memcmp(shown_display, frame->display, sizeof(shown_display)) != 0) {
+            platform_present(platform, frame->display);
+            memcpy(shown_display, frame->display, sizeof(shown_display));
+            shown = true;
+            atomic_fetch_add_explicit(&link->presents, 1, memory_order_relaxed);
+            stats_record_phase(stats, PHASE_RENDER, platform_time_ns() - t1);
+        }
+        if (frame->has_memory) {
+            // A missed capture means the dirty pages in between are unknown
+            uint64_t m0 = platform_time_ns();
+            uint64_t dirty = frame->memory_sequence == shown_memory_sequence + 1 ? frame->memory_dirty : ~0ull;
+            platform_present_memory(platform, frame->memory, dirty, frame->has_heat ? frame->heat : NULL);
+            shown_memory_sequence = frame->memory_sequence;
+            last_mem_vis_update = m0;
+            stats_record_phase(stats, PHASE_MEMORY, platform_time_ns() - m0);
+        }
+    }
 }
 
-static const SDL_Keycode keymap[NUM_KEYS] = {
-    SDLK_1, SDLK_2, SDLK_3, SDLK_4,
-    SDLK_q, SDLK_w, SDLK_e, SDLK_r,
-    SDLK_a, SDLK_s, SDLK_d, SDLK_f,
-    SDLK_z, SDLK_x, SDLK_c, SDLK_v
-};
+int main(int argc, char *argv[]) {
+    chip8_config config;
+    if (parse_arguments(argc, argv, &config) != 0)
+        return 1;
+    if (config.replay_path)
+        return replay_movie(&config);
+    
+    if (platform_interactive()) {
+        printf("\nPress Enter to continue...");
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF) { };
+    }
 
+    // chip8_t is large with the predecoded core, keep it off the stack
+    static chip8_t chip8;
+    chip8_initialize(&chip8, &config);
+    chip8_load_rom(&chip8, config.rom_path);
+    if (config.load_state_path) {
+        if (chip8_load_state(&chip8, config.load_state_path) != 0) {
+            chip8_shutdown(&chip8);
+            return 1;
+        }
+        printf("Restored state at cycle %" PRIu64 " from %s\n", chip8.cycles, config.load_state_path);
+        chip8.draw_flag = true;
+    }
 
-void handle_input(chip8_t* chip8, bool* running) {
-    SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        if (event.type == SDL_QUIT) *running = false;
-        if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-            for (int i = 0; i < NUM_KEYS; i++) {
-                if (event.key.keysym.sym == keymap[i]) {
-                    chip8->keypad[i] = (event.type == SDL_KEYDOWN) ? 1 : 0;
-                    break;
-                }
-            }
+    platform_t* platform = platform_create(&config);
+    if (!platform) {
+        chip8_shutdown(&chip8);
+        return 1;
+    }
+
+    // Rewind history, one frame per loop iteration while Backspace is not held
+    rewind_buffer_t* rewind = NULL;
+    if (config.rewind_seconds > 0) {
+        rewind = rewind_create(config.rewind_seconds * TIMER_RATE, (size_t)config.rewind_budget_kb * 1024);
+        if (!rewind) {
+            platform_destroy(platform);
+            chip8_shutdown(&chip8);
+            return 1;
+        }
+        rewind_push(rewind, &chip8);
+    }
+
+    movie_recorder_t* recorder = NULL;
+    if (config.record_path) {
+        recorder = movie_record_open(config.record_path, &chip8, config.seed);
+        if (!recorder) {
+            rewind_destroy(rewind);
+            platform_destroy(platform);
+            chip8_shutdown(&chip8);
+            return 1;
         }
-        if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) *running = false;
     }
-}
\ No newline at end of file
+
+    stats_exporter_t* stats = NULL;
+    if (config.stats_path) {
+        stats = stats_open(config.stats_path, phase_names, PHASE_COUNT);
+        if (!stats) {
+            if (recorder)
+                movie_record_close(recorder, &chip8);
+            rewind_destroy(rewind);
+            platform_destroy(platform);
+            chip8_shutdown(&chip8);
+            return 1;
+        }
+    }
+
+    // The triple buffer holds three memory images, keep it off the stack
+    static host_link_t link;
+    triple_buffer_init(&link.frames);
+    emulation_t emulation = { &chip8, &config, platform, rewind, recorder, stats, &link };
+    pthread_t emulation_thread;
+    int error = pthread_create(&emulation_thread, NULL, run_emulation, &emulation);
+    if (error == 0) {
+        run_presentation(platform, &config, &link, stats);
+        pthread_join(emulation_thread, NULL);
+    } else {
+        platform_log(LOG_ERROR, "Could not start the emulation thread: %s\n", strerror(error));
+    }
+
+    stats_close(stats, platform_time_ns(), chip8.cycles);
+    if (recorder && movie_record_close(recorder, &chip8) == 0)
+        printf("Recorded %" PRIu64 " cycles to %s (display hash %016" PRIx64 ")\n",
+               chip8.cycles, config.record_path, chip8_display_hash(chip8.display));
+    printf("Exiting...\n");
+    rewind_destroy(rewind);
+    platform_destroy(platform);
+    chip8_shutdown(&chip8);
+    return error == 0 ? 0 : 1;
+}
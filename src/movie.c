@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L
+#include "movie.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(movie_header_t) == 56, "movie_header_t must not contain padding");
+_Static_assert(sizeof(movie_event_t) == 16, "movie_event_t must not contain padding");
+
+struct movie_recorder {
+    FILE* file;
+    movie_header_t header;
+};
+
+uint64_t movie_rom_hash(const chip8_t* chip8) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int i = 0x200; i < MEMORY_SIZE; i++) {
+        hash ^= chip8->memory[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+movie_recorder_t* movie_record_open(const char* path, const chip8_t* chip8, uint64_t seed) {
+    movie_recorder_t* recorder = calloc(1, sizeof(*recorder));
+    if (!recorder)
+        return NULL;
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) {
+        fprintf(stderr, "Error: Could not open movie file %s\n", path);
+        free(recorder);
+        return NULL;
+    }
+    movie_header_t* header = &recorder->header;
+    memcpy(header->magic, MOVIE_MAGIC, sizeof(header->magic));
+    header->version = MOVIE_VERSION;
+    header->event_size = sizeof(movie_event_t);
+    header->clock_rate = chip8->clock_rate;
+    header->quirks = chip8->quirks;
+    header->seed = seed;
+    header->rom_hash = movie_rom_hash(chip8);
+    // Rewritten with the final counts by movie_record_close; events follow it as they happen
+    fwrite(header, sizeof(*header), 1, recorder->file);
+    return recorder;
+}
+
+void movie_record_keys(movie_recorder_t* recorder, const chip8_t* chip8, const uint8_t before[NUM_KEYS]) {
+    for (int key = 0; key < NUM_KEYS; key++) {
+        if ((before[key] != 0) == (chip8->keypad[key] != 0))
+            continue;
+        movie_event_t event = { .cycle = chip8->cycles, .key = (uint8_t)key, .down = chip8->keypad[key] != 0 };
+        fwrite(&event, sizeof(event), 1, recorder->file);
+        recorder->header.event_count++;
+    }
+}
+
+int movie_record_close(movie_recorder_t* recorder, const chip8_t* chip8) {
+    recorder->header.final_cycles = chip8->cycles;
+    recorder->header.final_display_hash = chip8_display_hash(chip8->display);
+    bool ok = fseek(recorder->file, 0, SEEK_SET) == 0
+        && fwrite(&recorder->header, sizeof(recorder->header), 1, recorder->file) == 1;
+    ok = (fclose(recorder->file) == 0) && ok;
+    if (!ok)
+        fprintf(stderr, "Error: Could not write the movie file\n");
+    free(recorder);
+    return ok ? 0 : 1;
+}
+
+int movie_load(const char* path, movie_t* movie) {
+    memset(movie, 0, sizeof(*movie));
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open movie file %s\n", path);
+        return 1;
+    }
+
+    movie_header_t* header = &movie->header;
+    struct stat st;
+    int result = 1;
+    if (fread(header, sizeof(*header), 1, file) != 1 || memcmp(header->magic, MOVIE_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "Error: %s is not a movie file\n", path);
+    } else if (header->version != MOVIE_VERSION) {
+        fprintf(stderr, "Error: %s is movie version %u, expected %u\n", path, header->version, MOVIE_VERSION);
+    } else if (header->event_size != sizeof(movie_event_t)) {
+        fprintf(stderr, "Error: %s has %u-byte events, expected %zu\n", path, header->event_size, sizeof(movie_event_t));
+    } else if (header->clock_rate == 0) {
+        fprintf(stderr, "Error: %s has no clock rate\n", path);
+    } else if (fstat(fileno(file), &st) != 0 || st.st_size < (off_t)sizeof(*header)) {
+        fprintf(stderr, "Error: Could not read the size of %s\n", path);
+    } else if (header->event_count > SIZE_MAX / sizeof(movie_event_t)
+               || header->event_count > ((uint64_t)st.st_size - sizeof(*header)) / sizeof(movie_event_t)) {
+        // Checked before allocating: the count comes from the file and could wrap the size
+        fprintf(stderr, "Error: %s claims %" PRIu64 " events, more than the file holds\n", path, header->event_count);
+    } else if (header->event_count > 0
+               && !(movie->events = malloc(header->event_count * sizeof(movie_event_t)))) {
+        fprintf(stderr, "Error: Out of memory loading %s\n", path);
+    } else if (fread(movie->events, sizeof(movie_event_t), header->event_count, file) != header->event_count) {
+        fprintf(stderr, "Error: %s is truncated\n", path);
+    } else {
+        result = 0;
+        for (uint64_t i = 0; i < header->event_count && result == 0; i++) {
+            const movie_event_t* event = &movie->events[i];
+            if (event->key >= NUM_KEYS || event->cycle > header->final_cycles
+                || (i > 0 && event->cycle < event[-1].cycle)) {
+                fprintf(stderr, "Error: %s has an invalid event at index %" PRIu64 "\n", path, i);
+                result = 1;
+            }
+        }
+    }
+    fclose(file);
+    if (result != 0)
+        movie_free(movie);
+    return result;
+}
+
+void movie_free(movie_t* movie) {
+    free(movie->events);
+    movie->events = NULL;
+}
+
+int movie_replay(chip8_t* chip8, const movie_t* movie) {
+    const movie_header_t* header = &movie->header;
+    uint64_t next_event = 0;
+    while (chip8->cycles < header->final_cycles) {
+        while (next_event < header->event_count && movie->events[next_event].cycle <= chip8->cycles) {
+            chip8->keypad[movie->events[next_event].key] = movie->events[next_event].down;
+            next_event++;
+        }
+        // Stop at every timer tick and at the next event, like the host does between frames
+        uint64_t run = chip8_cycles_until_tick(chip8);
+        if (header->final_cycles - chip8->cycles < run)
+            run = header->final_cycles - chip8->cycles;
+        if (next_event < header->event_count && movie->events[next_event].cycle - chip8->cycles < run)
+            run = movie->events[next_event].cycle - chip8->cycles;
+        chip8_run_cycles(chip8, (uint32_t)run);
+        while (chip8_cycles_until_tick(chip8) == 0)
+            update_timers(chip8);
+    }
+    // Transitions logged at the very last cycle still count, the recording ended after them
+    for (; next_event < header->event_count; next_event++)
+        chip8->keypad[movie->events[next_event].key] = movie->events[next_event].down;
+    return chip8_display_hash(chip8->display) == header->final_display_hash ? 0 : 1;
+}
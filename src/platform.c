@@ -0,0 +1,35 @@
+#define _POSIX_C_SOURCE 200809L
+#include "platform.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <errno.h>
+
+/*
+    Backend-independent parts of the host interface: time and logging.
+*/
+
+uint64_t platform_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void platform_sleep_until_ns(uint64_t deadline_ns) {
+    struct timespec ts = {
+        .tv_sec = deadline_ns / 1000000000ull,
+        .tv_nsec = deadline_ns % 1000000000ull
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) { }
+}
+
+void platform_log(log_level_t level, const char* fmt, ...) {
+    FILE* out = level == LOG_ERROR ? stderr : stdout;
+    if (level == LOG_ERROR)
+        fputs("Error: ", out);
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(out, fmt, args);
+    va_end(args);
+}
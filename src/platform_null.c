@@ -0,0 +1,79 @@
+#include "platform.h"
+#include <stdlib.h>
+
+/*
+    Headless backend (make PLATFORM=null). Nothing is shown or played, no
+    input ever arrives and the host never prompts on the console, so runs
+    start immediately and need no display or libSDL2.
+*/
+
+struct platform {
+    int unused;
+};
+
+platform_t* platform_create(const chip8_config* config) {
+    (void)config;
+    platform_t* platform = calloc(1, sizeof(*platform));
+    if (!platform)
+        platform_log(LOG_ERROR, "Could not allocate the headless platform\n");
+    return platform;
+}
+
+void platform_destroy(platform_t* platform) {
+    free(platform);
+}
+
+const char* platform_name(void) {
+    return "null";
+}
+
+bool platform_interactive(void) {
+    return false;
+}
+
+void platform_present(platform_t* platform, const uint64_t display[DISPLAY_HEIGHT]) {
+    (void)platform;
+    (void)display;
+}
+
+void platform_present_memory(platform_t* platform, const uint8_t memory[MEMORY_SIZE], uint64_t memory_dirty,
+                             const uint8_t heat[HEAT_KINDS][MEMORY_SIZE]) {
+    (void)platform;
+    (void)memory;
+    (void)memory_dirty;
+    (void)heat;
+}
+
+bool platform_poll_input(platform_t* platform, uint8_t keypad[NUM_KEYS], uint32_t* commands) {
+    (void)platform;
+    (void)keypad;
+    *commands = 0;
+    return true;
+}
+
+uint32_t platform_audio_rate(platform_t* platform) {
+    (void)platform;
+    return 0;
+}
+
+uint32_t platform_audio_buffer(platform_t* platform) {
+    (void)platform;
+    return 0;
+}
+
+uint32_t platform_audio_queued(platform_t* platform) {
+    (void)platform;
+    return 0;
+}
+
+uint32_t platform_audio_write(platform_t* platform, const int16_t* samples, uint32_t count) {
+    (void)platform;
+    (void)samples;
+    (void)count;
+    return 0;
+}
+
+void platform_set_tone(platform_t* platform, bool on) {
+    (void)platform;
+    (void)on;
+}
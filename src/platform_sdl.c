@@ -0,0 +1,348 @@
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <SDL2/SDL.h>
+#include "audio.h"
+
+/*
+    SDL2 backend (default): the main window, the keyboard keypad, the
+    optional memory visualiser window and buzzer audio. Audio works with any
+    SDL audio driver, including SDL_AUDIODRIVER=dummy or disk on machines
+    without sound hardware; if no device opens, the end of each tone is
+    printed instead.
+*/
+
+#define MEM_VIS_SCREEN_WIDTH  512
+#define MEM_VIS_SCREEN_HEIGHT 512
+#define MEM_VIS_BYTES_PER_ROW MEMORY_PAGE_SIZE // one texture row per memory page
+#define MEM_VIS_ROWS          (MEMORY_SIZE / MEM_VIS_BYTES_PER_ROW)
+
+typedef struct {
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    SDL_Texture* texture; // one texel per memory byte
+} MemoryVisualiser_t;
+
+struct platform {
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;                // DISPLAY_WIDTH x DISPLAY_HEIGHT streaming texture
+    uint64_t presented[DISPLAY_HEIGHT];  // display contents currently in the texture
+    bool texture_valid;
+    bool mem_vis_enabled;
+    MemoryVisualiser_t mem_vis;
+    bool tone_on;
+    bool rewind_held;
+    SDL_AudioDeviceID audio_device;      // 0 if no audio device is open
+    audio_ring_t* audio;                 // filled by the emulation thread, drained by audio_callback
+    uint32_t audio_rate;
+    uint32_t audio_buffer;               // device buffer, samples
+    uint32_t audio_cap;                  // most samples kept queued, beyond it new ones are dropped
+    uint64_t audio_dropped;
+    bool audio_started;                  // the device is unpaused once the first samples are queued
+};
+
+static const SDL_Keycode keymap[NUM_KEYS] = {
+    SDLK_1, SDLK_2, SDLK_3, SDLK_4,
+    SDLK_q, SDLK_w, SDLK_e, SDLK_r,
+    SDLK_a, SDLK_s, SDLK_d, SDLK_f,
+    SDLK_z, SDLK_x, SDLK_c, SDLK_v
+};
+
+static int memory_visualiser_init(MemoryVisualiser_t* mem_vis, int x) {
+    mem_vis->window = SDL_CreateWindow("Memory Visualiser",
+                                       x,
+                                       SDL_WINDOWPOS_UNDEFINED,
+                                       MEM_VIS_SCREEN_WIDTH,
+                                       MEM_VIS_SCREEN_HEIGHT,
+                                       SDL_WINDOW_SHOWN);
+    if (!mem_vis->window) {
+        platform_log(LOG_ERROR, "Could not create window: %s\n", SDL_GetError());
+        return 1;
+    }
+    mem_vis->renderer = SDL_CreateRenderer(mem_vis->window, -1, SDL_RENDERER_ACCELERATED);
+    if (!mem_vis->renderer) {
+        platform_log(LOG_ERROR, "Could not create renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+    mem_vis->texture = SDL_CreateTexture(mem_vis->renderer,
+                                         SDL_PIXELFORMAT_ARGB8888,
+                                         SDL_TEXTUREACCESS_STREAMING,
+                                         MEM_VIS_BYTES_PER_ROW,
+                                         MEM_VIS_ROWS);
+    if (!mem_vis->texture) {
+        platform_log(LOG_ERROR, "Could not create texture: %s\n", SDL_GetError());
+        return 1;
+    }
+    return 0;
+}
+
+// Runs on SDL's audio thread
+static void audio_callback(void* userdata, Uint8* stream, int len) {
+    platform_t* platform = userdata;
+    int16_t* samples = (int16_t*)stream;
+    uint32_t wanted = (uint32_t)len / sizeof(int16_t);
+    uint32_t got = audio_ring_read(platform->audio, samples, wanted);
+    memset(samples + got, 0, (wanted - got) * sizeof(int16_t));
+}
+
+/*
+    Opens the default audio device for signed 16-bit mono with the requested
+    buffer size; the driver may grant a different one. The queue is capped
+    at one emulated frame plus two granted buffers; main keeps it near one
+    (platform_audio_buffer), so a tone starts within about two device
+    buffers (5.3 ms if the default 128 samples at 48 kHz are granted).
+*/
+static int audio_open(platform_t* platform, const chip8_config* config) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+        return 1;
+    SDL_AudioSpec want = {0}, have;
+    want.freq = AUDIO_SAMPLE_RATE;
+    want.format = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples = (Uint16)(config->audio_buffer < 32768 ? config->audio_buffer : 32768);
+    want.callback = audio_callback;
+    want.userdata = platform;
+    platform->audio_device = SDL_OpenAudioDevice(NULL, 0, &want, &have,
+                                                 SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+    if (platform->audio_device == 0)
+        return 1;
+    platform->audio_rate = (uint32_t)have.freq;
+    platform->audio_buffer = have.samples;
+    platform->audio_cap = platform->audio_rate / TIMER_RATE + 2 * platform->audio_buffer;
+    platform->audio = audio_ring_create(platform->audio_cap);
+    if (!platform->audio || platform->audio_rate / TIMER_RATE + 1 > AUDIO_MAX_FRAME_SAMPLES) {
+        SDL_CloseAudioDevice(platform->audio_device);
+        platform->audio_device = 0;
+        return 1;
+    }
+    return 0;
+}
+
+platform_t* platform_create(const chip8_config* config) {
+    const int screen_width = DISPLAY_WIDTH * config->scale_factor;
+    const int screen_height = DISPLAY_HEIGHT * config->scale_factor;
+
+    platform_t* platform = calloc(1, sizeof(*platform));
+    if (!platform) {
+        platform_log(LOG_ERROR, "Could not allocate the SDL platform\n");
+        return NULL;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        platform_log(LOG_ERROR, "Could not initialize SDL: %s\n", SDL_GetError());
+        free(platform);
+        return NULL;
+    }
+
+    platform->window = SDL_CreateWindow("CHIP-8 Emulator",
+                                        SDL_WINDOWPOS_UNDEFINED,
+                                        SDL_WINDOWPOS_UNDEFINED,
+                                        screen_width,
+                                        screen_height,
+                                        SDL_WINDOW_SHOWN);
+    if (!platform->window) {
+        platform_log(LOG_ERROR, "Could not create window: %s\n", SDL_GetError());
+        platform_destroy(platform);
+        return NULL;
+    }
+
+    // Presents wait for vsync; they run on their own thread, so emulation never waits for them
+    platform->renderer = SDL_CreateRenderer(platform->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (!platform->renderer) {
+        platform_log(LOG_ERROR, "Could not create renderer: %s\n", SDL_GetError());
+        platform_destroy(platform);
+        return NULL;
+    }
+
+    platform->texture = SDL_CreateTexture(platform->renderer,
+                                          SDL_PIXELFORMAT_ARGB8888,
+                                          SDL_TEXTUREACCESS_STREAMING,
+                                          DISPLAY_WIDTH,
+                                          DISPLAY_HEIGHT);
+    if (!platform->texture) {
+        platform_log(LOG_ERROR, "Could not create display texture: %s\n", SDL_GetError());
+        platform_destroy(platform);
+        return NULL;
+    }
+
+    // Memory visualiser window, only when requested with -v, placed to the right of the main one
+    if (config->memory_visualiser) {
+        int main_x, main_y, main_w, main_h;
+        SDL_GetWindowPosition(platform->window, &main_x, &main_y);
+        SDL_GetWindowSize(platform->window, &main_w, &main_h);
+        if (memory_visualiser_init(&platform->mem_vis, main_x + main_w) == 0)
+            platform->mem_vis_enabled = true;
+        else
+            platform_log(LOG_INFO, "Memory visualiser initialisastion failed.\n");
+    }
+
+    if (audio_open(platform, config) == 0)
+        platform_log(LOG_INFO, "Audio: %s, %u Hz, %u-sample buffer\n", SDL_GetCurrentAudioDriver(),
+                     platform->audio_rate, platform->audio_buffer);
+    else
+        platform_log(LOG_INFO, "No audio device (%s), the buzzer is reported on the console\n", SDL_GetError());
+    return platform;
+}
+
+void platform_destroy(platform_t* platform) {
+    if (!platform)
+        return;
+    if (platform->audio_device) {
+        SDL_CloseAudioDevice(platform->audio_device);
+        platform_log(LOG_INFO, "Audio: %" PRIu64 " underruns, %" PRIu64 " samples dropped\n",
+                     (uint64_t)atomic_load(&platform->audio->underruns), platform->audio_dropped);
+    }
+    audio_ring_destroy(platform->audio);
+    if (platform->mem_vis.texture) SDL_DestroyTexture(platform->mem_vis.texture);
+    if (platform->mem_vis.renderer) SDL_DestroyRenderer(platform->mem_vis.renderer);
+    if (platform->mem_vis.window) SDL_DestroyWindow(platform->mem_vis.window);
+    if (platform->texture) SDL_DestroyTexture(platform->texture);
+    if (platform->renderer) SDL_DestroyRenderer(platform->renderer);
+    if (platform->window) SDL_DestroyWindow(platform->window);
+    SDL_Quit();
+    free(platform);
+}
+
+const char* platform_name(void) {
+    return "sdl";
+}
+
+bool platform_interactive(void) {
+    return true;
+}
+
+void platform_present(platform_t* platform, const uint64_t display[DISPLAY_HEIGHT]) {
+    /*
+        1. If the display changed since the last present, expand the packed rows
+           into the streaming texture: one ARGB word per pixel, branch-free so
+           the inner loop vectorises
+        2. Let the GPU scale the 64x32 texture to the window with one copy
+        The cost does not depend on the scale factor or on how many pixels are lit.
+    */
+    if (!platform->texture_valid || memcmp(platform->presented, display, sizeof(platform->presented)) != 0) {
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(platform->texture, NULL, &pixels, &pitch) == 0) {
+            for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+                uint32_t* line = (uint32_t*)((uint8_t*)pixels + (y * pitch));
+                uint64_t row = display[y];
+                for (int x = 0; x < DISPLAY_WIDTH; x++) {
+                    uint32_t lit = (uint32_t)(row >> (DISPLAY_WIDTH - 1 - x)) & 1;
+                    line[x] = 0xFF000000u | (0x00FFFFFFu & -lit); // white or black
+                }
+            }
+            SDL_UnlockTexture(platform->texture);
+            memcpy(platform->presented, display, sizeof(platform->presented));
+            platform->texture_valid = true;
+        }
+    }
+
+    SDL_RenderCopy(platform->renderer, platform->texture, NULL, NULL);
+    SDL_RenderPresent(platform->renderer);
+}
+
+void platform_present_memory(platform_t* platform, const uint8_t memory[MEMORY_SIZE], uint64_t memory_dirty,
+                             const uint8_t heat[HEAT_KINDS][MEMORY_SIZE]) {
+    /*
+        Memory is shown as a 64x64 texture, one texel per byte with the
+        brightness given by its value. Only rows whose page was written since
+        the last refresh are re-uploaded; nothing is drawn if none were.
+        With heat the value is dimmed and recent accesses are added on top:
+        writes in red, reads in green, fetches in blue. The heat changes
+        every refresh, so then all rows are uploaded.
+    */
+    if (!platform->mem_vis_enabled || (memory_dirty == 0 && !heat))
+        return;
+
+    MemoryVisualiser_t* mem_vis = &platform->mem_vis;
+    uint32_t line[MEM_VIS_BYTES_PER_ROW];
+    for (int row = 0; row < MEM_VIS_ROWS; row++) {
+        if (!heat && !(memory_dirty & (1ull << row)))
+            continue;
+        const int base = row * MEM_VIS_BYTES_PER_ROW;
+        const uint8_t* bytes = &memory[base];
+        for (int i = 0; i < MEM_VIS_BYTES_PER_ROW; i++) {
+            if (!heat) {
+                line[i] = 0xFF000000u | (bytes[i] << 16) | (bytes[i] << 8) | bytes[i];
+                continue;
+            }
+            uint32_t grey = bytes[i] / 4;
+            uint32_t r = grey + heat[HEAT_WRITE][base + i];
+            uint32_t g = grey + heat[HEAT_READ][base + i];
+            uint32_t b = grey + heat[HEAT_EXECUTE][base + i];
+            line[i] = 0xFF000000u | ((r > 255 ? 255 : r) << 16) | ((g > 255 ? 255 : g) << 8) | (b > 255 ? 255 : b);
+        }
+        SDL_Rect row_rect = { 0, row, MEM_VIS_BYTES_PER_ROW, 1 };
+        SDL_UpdateTexture(mem_vis->texture, &row_rect, line, sizeof(line));
+    }
+
+    SDL_RenderCopy(mem_vis->renderer, mem_vis->texture, NULL, NULL);
+    SDL_RenderPresent(mem_vis->renderer);
+}
+
+bool platform_poll_input(platform_t* platform, uint8_t keypad[NUM_KEYS], uint32_t* commands) {
+    bool running = true;
+    *commands = 0;
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        if (event.type == SDL_QUIT) running = false;
+        if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+            for (int i = 0; i < NUM_KEYS; i++) {
+                if (event.key.keysym.sym == keymap[i]) {
+                    keypad[i] = (event.type == SDL_KEYDOWN) ? 1 : 0;
+                    break;
+                }
+            }
+        }
+        if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) running = false;
+        if (event.type == SDL_KEYDOWN && !event.key.repeat) {
+            if (event.key.keysym.sym == SDLK_F5) *commands |= PLATFORM_CMD_SAVE_STATE;
+            if (event.key.keysym.sym == SDLK_F9) *commands |= PLATFORM_CMD_LOAD_STATE;
+        }
+        if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && event.key.keysym.sym == SDLK_BACKSPACE)
+            platform->rewind_held = event.type == SDL_KEYDOWN;
+    }
+    if (platform->rewind_held)
+        *commands |= PLATFORM_CMD_REWIND;
+    return running;
+}
+
+uint32_t platform_audio_rate(platform_t* platform) {
+    return platform->audio_device ? platform->audio_rate : 0;
+}
+
+uint32_t platform_audio_buffer(platform_t* platform) {
+    return platform->audio_device ? platform->audio_buffer : 0;
+}
+
+uint32_t platform_audio_queued(platform_t* platform) {
+    return platform->audio_device ? audio_ring_queued(platform->audio) : 0;
+}
+
+uint32_t platform_audio_write(platform_t* platform, const int16_t* samples, uint32_t count) {
+    if (!platform->audio_device)
+        return 0;
+    uint32_t queued = audio_ring_queued(platform->audio);
+    uint32_t room = queued < platform->audio_cap ? platform->audio_cap - queued : 0;
+    uint32_t written = audio_ring_write(platform->audio, samples, count < room ? count : room);
+    platform->audio_dropped += count - written;
+    // Starting on the first samples keeps the callback from counting underruns before there was anything to play
+    if (!platform->audio_started && written > 0) {
+        SDL_PauseAudioDevice(platform->audio_device, 0);
+        platform->audio_started = true;
+    }
+    return written;
+}
+
+void platform_set_tone(platform_t* platform, bool on) {
+    // With an audio device the emulation thread queues the tone itself
+    if (platform->audio_device)
+        return;
+    // Without one, the end of each tone is reported on the console
+    if (platform->tone_on && !on)
+        printf("BEEP!\n");
+    platform->tone_on = on;
+}
@@ -0,0 +1,309 @@
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "chip8.h"
+
+#define HOT_ADDRESSES 32 // rows in the flat profile, the CSV has all of them
+#define NO_FRAME 0xFFFF
+#define MAIN_ENTRY MEMORY_SIZE // entry of the root frame, subroutine entries are 12-bit addresses
+
+/*
+    Calling contexts form a tree: frame 0 is the program itself, and each
+    frame's children are the subroutines called from it, one frame per
+    distinct callee. Counting an instruction is one increment on the
+    current frame; a call or return moves to a child or back to the parent.
+*/
+typedef struct {
+    uint16_t entry;  // subroutine address, MAIN_ENTRY for the root
+    uint16_t parent;
+    uint16_t first_child;
+    uint16_t next_sibling;
+    uint64_t calls;
+    uint64_t instructions; // executed in this context, not counting callees
+} profile_frame_t;
+
+struct chip8_profile {
+    char* prefix;
+    uint64_t instructions;
+    uint64_t class_counts[PROFILE_CLASSES];
+    uint64_t pc_counts[MEMORY_SIZE];
+    uint16_t pc_opcodes[MEMORY_SIZE]; // last opcode executed at each address
+    uint16_t current;
+    uint16_t frame_count;
+    uint64_t untracked_depth; // calls made with no frame left, their returns must not pop a frame
+    profile_frame_t frames[PROFILE_MAX_FRAMES];
+};
+
+chip8_profile_t* profile_open(const char* prefix) {
+    chip8_profile_t* profile = calloc(1, sizeof(*profile));
+    if (profile)
+        profile->prefix = malloc(strlen(prefix) + 1);
+    if (!profile || !profile->prefix) {
+        fprintf(stderr, "Error: Could not allocate the profiler\n");
+        free(profile);
+        return NULL;
+    }
+    strcpy(profile->prefix, prefix);
+    profile->frames[0] = (profile_frame_t){ .entry = MAIN_ENTRY, .parent = NO_FRAME,
+                                            .first_child = NO_FRAME, .next_sibling = NO_FRAME };
+    profile->frame_count = 1;
+    return profile;
+}
+
+static void profile_call(chip8_profile_t* profile, uint16_t target) {
+    if (profile->untracked_depth > 0) {
+        profile->untracked_depth++;
+        return;
+    }
+    profile_frame_t* caller = &profile->frames[profile->current];
+    uint16_t child = caller->first_child;
+    while (child != NO_FRAME && profile->frames[child].entry != target)
+        child = profile->frames[child].next_sibling;
+    if (child == NO_FRAME) {
+        if (profile->frame_count == PROFILE_MAX_FRAMES) {
+            // Typically a ROM that leaves subroutines with a jump: the context keeps growing
+            profile->untracked_depth = 1;
+            return;
+        }
+        child = profile->frame_count++;
+        profile->frames[child] = (profile_frame_t){ .entry = target, .parent = profile->current,
+                                                    .first_child = NO_FRAME, .next_sibling = caller->first_child };
+        caller->first_child = child;
+    }
+    profile->frames[child].calls++;
+    profile->current = child;
+}
+
+static void profile_return(chip8_profile_t* profile) {
+    if (profile->untracked_depth > 0)
+        profile->untracked_depth--;
+    else if (profile->current != 0) // 00EE with nothing to return from stays in the root
+        profile->current = profile->frames[profile->current].parent;
+}
+
+void profile_instruction(chip8_profile_t* profile, uint16_t pc, uint16_t opcode) {
+    profile->instructions++;
+    profile->class_counts[profile_class(opcode)]++;
+    profile->pc_counts[pc]++;
+    profile->pc_opcodes[pc] = opcode;
+    profile->frames[profile->current].instructions++;
+    if ((opcode >> 12) == 0x2)
+        profile_call(profile, opcode & 0x0FFF);
+    else if (opcode == 0x00EE)
+        profile_return(profile);
+}
+
+// --- Reports ---
+
+static const char* class_name(uint16_t index, char name[8]) {
+    static const char* top[16] = {
+        "0nnn", "1nnn", "2nnn", "3xkk", "4xkk", "5xy0", "6xkk", "7xkk",
+        "8xyn", "9xy0", "Annn", "Bnnn", "Cxkk", "Dxyn", "Exkk", "Fxkk"
+    };
+    static const uint8_t known_Fxxx[] = { 0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x33, 0x55, 0x65 };
+    if (index < PROFILE_CLASS_8xxx)
+        return top[index];
+    if (index < PROFILE_CLASS_0xxx) {
+        snprintf(name, 8, "8xy%X", index - PROFILE_CLASS_8xxx);
+        return name;
+    }
+    // Subtable leaves without a handler get a '?' in place of x
+    uint8_t kk;
+    bool known;
+    char nibble;
+    if (index < PROFILE_CLASS_Exxx) {
+        kk = index - PROFILE_CLASS_0xxx;
+        known = kk == 0xE0 || kk == 0xEE;
+        nibble = '0';
+    } else if (index < PROFILE_CLASS_Fxxx) {
+        kk = index - PROFILE_CLASS_Exxx;
+        known = kk == 0x9E || kk == 0xA1;
+        nibble = 'E';
+    } else {
+        kk = index - PROFILE_CLASS_Fxxx;
+        known = memchr(known_Fxxx, kk, sizeof(known_Fxxx)) != NULL;
+        nibble = 'F';
+    }
+    snprintf(name, 8, "%c%c%02X", nibble, known ? (nibble == '0' ? '0' : 'x') : '?', kk);
+    return name;
+}
+
+static const char* function_name(uint16_t entry, char name[12]) {
+    if (entry == MAIN_ENTRY)
+        return "main";
+    snprintf(name, 12, "sub_%03X", entry);
+    return name;
+}
+
+static double share(uint64_t count, uint64_t total) {
+    return total ? 100.0 * count / total : 0.0;
+}
+
+typedef struct {
+    uint64_t count;
+    uint16_t key;
+    uint16_t value;
+} ranked_t;
+
+static int compare_ranked(const void* a, const void* b) {
+    const ranked_t* x = a;
+    const ranked_t* y = b;
+    if (x->count != y->count)
+        return x->count < y->count ? 1 : -1;
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+    return (x->value > y->value) - (x->value < y->value);
+}
+
+#define MAX_OF(a, b) ((a) > (b) ? (a) : (b))
+#define RANKED_MAX MAX_OF(PROFILE_CLASSES, MAX_OF(MEMORY_SIZE, PROFILE_MAX_FRAMES))
+
+static void write_flat(const chip8_profile_t* profile, FILE* out) {
+    // Rows of every table below: classes, addresses, functions and call edges all fit
+    ranked_t* ranked = malloc(RANKED_MAX * sizeof(ranked_t));
+    uint64_t* self = calloc(MAIN_ENTRY + 1, sizeof(uint64_t));
+    uint64_t* calls = calloc(MAIN_ENTRY + 1, sizeof(uint64_t));
+    if (!ranked || !self || !calls) {
+        fprintf(stderr, "Error: Out of memory writing the profile\n");
+        free(ranked);
+        free(self);
+        free(calls);
+        return;
+    }
+    uint64_t total = profile->instructions;
+    char name[12];
+    size_t count = 0;
+
+    fprintf(out, "Profile of %" PRIu64 " instructions\n\nOpcode classes:\n", total);
+    fprintf(out, "%14s %7s  %s\n", "count", "share", "class");
+    for (uint16_t i = 0; i < PROFILE_CLASSES; i++)
+        if (profile->class_counts[i])
+            ranked[count++] = (ranked_t){ profile->class_counts[i], i, 0 };
+    qsort(ranked, count, sizeof(ranked_t), compare_ranked);
+    for (size_t i = 0; i < count; i++)
+        fprintf(out, "%14" PRIu64 " %6.2f%%  %s\n", ranked[i].count, share(ranked[i].count, total),
+                class_name(ranked[i].key, name));
+
+    count = 0;
+    for (uint16_t pc = 0; pc < MEMORY_SIZE; pc++)
+        if (profile->pc_counts[pc])
+            ranked[count++] = (ranked_t){ profile->pc_counts[pc], pc, profile->pc_opcodes[pc] };
+    qsort(ranked, count, sizeof(ranked_t), compare_ranked);
+    fprintf(out, "\nHot addresses (%zu executed, top %d):\n", count, HOT_ADDRESSES);
+    fprintf(out, "%14s %7s  %-4s %-6s %s\n", "count", "share", "pc", "opcode", "class");
+    for (size_t i = 0; i < count && i < HOT_ADDRESSES; i++)
+        fprintf(out, "%14" PRIu64 " %6.2f%%  %03X  %04X   %s\n", ranked[i].count, share(ranked[i].count, total),
+                ranked[i].key, ranked[i].value, class_name(profile_class(ranked[i].value), name));
+
+    // Functions: frames merged by entry address, main is kept apart as MAIN_ENTRY
+    for (uint16_t f = 0; f < profile->frame_count; f++) {
+        self[profile->frames[f].entry] += profile->frames[f].instructions;
+        calls[profile->frames[f].entry] += profile->frames[f].calls;
+    }
+    count = 0;
+    for (uint16_t entry = 0; entry <= MAIN_ENTRY; entry++)
+        if (self[entry] || calls[entry])
+            ranked[count++] = (ranked_t){ self[entry], entry, 0 };
+    qsort(ranked, count, sizeof(ranked_t), compare_ranked);
+    fprintf(out, "\nFunctions (instructions executed in the function itself):\n");
+    fprintf(out, "%14s %7s %12s  %s\n", "count", "share", "calls", "function");
+    for (size_t i = 0; i < count; i++)
+        fprintf(out, "%14" PRIu64 " %6.2f%% %12" PRIu64 "  %s\n", ranked[i].count, share(ranked[i].count, total),
+                calls[ranked[i].key], function_name(ranked[i].key, name));
+
+    // Call graph: 2nnn edges merged across contexts. key: caller entry, value: callee.
+    count = 0;
+    for (uint16_t f = 1; f < profile->frame_count; f++) {
+        const profile_frame_t* frame = &profile->frames[f];
+        uint16_t caller = profile->frames[frame->parent].entry;
+        size_t i = 0;
+        while (i < count && (ranked[i].key != caller || ranked[i].value != frame->entry))
+            i++;
+        if (i == count)
+            ranked[count++] = (ranked_t){ 0, caller, frame->entry };
+        ranked[i].count += frame->calls;
+    }
+    qsort(ranked, count, sizeof(ranked_t), compare_ranked);
+    fprintf(out, "\nCall graph:\n%14s  %s\n", "calls", "caller -> callee");
+    for (size_t i = 0; i < count; i++) {
+        char callee[12];
+        fprintf(out, "%14" PRIu64 "  %s -> %s\n", ranked[i].count,
+                function_name(ranked[i].key, name), function_name(ranked[i].value, callee));
+    }
+    if (profile->frame_count == PROFILE_MAX_FRAMES)
+        fprintf(out, "\nMore than %d calling contexts: deeper calls are counted in their caller.\n", PROFILE_MAX_FRAMES);
+    free(ranked);
+    free(self);
+    free(calls);
+}
+
+static void write_stack(const chip8_profile_t* profile, uint16_t frame, FILE* out) {
+    if (profile->frames[frame].parent != NO_FRAME) {
+        char name[12];
+        write_stack(profile, profile->frames[frame].parent, out);
+        fprintf(out, ";%s", function_name(profile->frames[frame].entry, name));
+    } else {
+        fprintf(out, "main");
+    }
+}
+
+static void write_folded(const chip8_profile_t* profile, FILE* out) {
+    for (uint16_t f = 0; f < profile->frame_count; f++) {
+        if (profile->frames[f].instructions == 0)
+            continue;
+        write_stack(profile, f, out);
+        fprintf(out, " %" PRIu64 "\n", profile->frames[f].instructions);
+    }
+}
+
+static void write_csv(const chip8_profile_t* profile, FILE* out) {
+    char name[8];
+    fprintf(out, "pc,opcode,class,count,share\n");
+    for (uint16_t pc = 0; pc < MEMORY_SIZE; pc++) {
+        if (profile->pc_counts[pc] == 0)
+            continue;
+        fprintf(out, "0x%03X,0x%04X,%s,%" PRIu64 ",%.4f\n", pc, profile->pc_opcodes[pc],
+                class_name(profile_class(profile->pc_opcodes[pc]), name), profile->pc_counts[pc],
+                share(profile->pc_counts[pc], profile->instructions));
+    }
+}
+
+static int write_report(const chip8_profile_t* profile, const char* extension,
+                        void (*write)(const chip8_profile_t*, FILE*)) {
+    size_t length = strlen(profile->prefix) + strlen(extension) + 1;
+    char* path = malloc(length);
+    if (!path)
+        return 1;
+    snprintf(path, length, "%s%s", profile->prefix, extension);
+    FILE* out = fopen(path, "w");
+    int result = 1;
+    if (!out) {
+        fprintf(stderr, "Error: Could not open profile report %s\n", path);
+    } else {
+        write(profile, out);
+        result = fclose(out) == 0 ? 0 : 1;
+        if (result != 0)
+            fprintf(stderr, "Error: Could not write profile report %s\n", path);
+    }
+    free(path);
+    return result;
+}
+
+int profile_close(chip8_profile_t* profile) {
+    if (!profile)
+        return 0;
+    int result = 0;
+    if (profile->instructions > 0) {
+        result |= write_report(profile, ".txt", write_flat);
+        result |= write_report(profile, ".folded", write_folded);
+        result |= write_report(profile, ".csv", write_csv);
+        if (result == 0)
+            printf("Profile of %" PRIu64 " instructions written to %s.{txt,folded,csv}\n",
+                   profile->instructions, profile->prefix);
+    }
+    free(profile->prefix);
+    free(profile);
+    return result;
+}
@@ -0,0 +1,243 @@
+#include "rewind.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STATE_WORDS (sizeof(snapshot_state_t) / sizeof(uint64_t))
+// Worst case: every other word differs, each literal word then costs a 4-byte run header
+#define MAX_ENCODED_SIZE (sizeof(snapshot_state_t) + 4 * (STATE_WORDS + 1))
+#define MIN_BUDGET_BYTES (4 * MAX_ENCODED_SIZE)
+
+_Static_assert(sizeof(snapshot_state_t) % sizeof(uint64_t) == 0, "the delta encoder works on whole words");
+
+typedef struct {
+    size_t offset;         // start of the encoded frame in the byte ring
+    uint32_t length;
+    uint64_t keyframe_seq; // sequence number of the keyframe it is a delta of, its own for keyframes
+} rewind_entry_t;
+
+struct rewind_buffer {
+    uint8_t* data;   // byte ring holding the encoded frames, oldest first
+    size_t capacity;
+    size_t write;    // where the next frame starts
+    size_t used;
+    rewind_entry_t* entries; // indexed by sequence number % max_frames
+    uint32_t max_frames;
+    uint64_t first_seq; // live frames are [first_seq, next_seq)
+    uint64_t next_seq;
+    snapshot_state_t keyframe; // decoded keyframe_seq, the base of most deltas
+    uint64_t cached_keyframe_seq;
+    bool keyframe_valid;
+    uint8_t scratch[MAX_ENCODED_SIZE];
+};
+
+static inline uint64_t load_word(const snapshot_state_t* state, size_t i) {
+    uint64_t word;
+    memcpy(&word, (const uint8_t*)state + i * sizeof(uint64_t), sizeof(word));
+    return word;
+}
+
+static inline void put_u16(uint8_t* out, size_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static inline size_t get_u16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+/*
+    Encodes state XOR base (base NULL: all zeros, i.e. a keyframe) as runs of
+    [u16 unchanged words][u16 changed words][changed words XOR base].
+    Returns the encoded length.
+*/
+static size_t delta_encode(const snapshot_state_t* state, const snapshot_state_t* base, uint8_t* out) {
+    size_t length = 0;
+    size_t i = 0;
+    while (i < STATE_WORDS) {
+        size_t skip = i;
+        while (skip < STATE_WORDS && load_word(state, skip) == (base ? load_word(base, skip) : 0))
+            skip++;
+        size_t literal = skip;
+        while (literal < STATE_WORDS && load_word(state, literal) != (base ? load_word(base, literal) : 0))
+            literal++;
+        put_u16(out + length, skip - i);
+        put_u16(out + length + 2, literal - skip);
+        length += 4;
+        for (size_t w = skip; w < literal; w++) {
+            uint64_t delta = load_word(state, w) ^ (base ? load_word(base, w) : 0);
+            memcpy(out + length, &delta, sizeof(delta));
+            length += sizeof(delta);
+        }
+        i = literal;
+    }
+    return length;
+}
+
+static void delta_decode(const uint8_t* in, size_t length, const snapshot_state_t* base, snapshot_state_t* state) {
+    if (base)
+        memcpy(state, base, sizeof(*state));
+    else
+        memset(state, 0, sizeof(*state));
+    uint8_t* bytes = (uint8_t*)state;
+    size_t pos = 0, w = 0;
+    while (pos + 4 <= length) {
+        w += get_u16(in + pos);
+        size_t literal = get_u16(in + pos + 2);
+        pos += 4;
+        for (; literal > 0; literal--, w++, pos += sizeof(uint64_t)) {
+            uint64_t word, delta;
+            memcpy(&word, bytes + w * sizeof(uint64_t), sizeof(word));
+            memcpy(&delta, in + pos, sizeof(delta));
+            word ^= delta;
+            memcpy(bytes + w * sizeof(uint64_t), &word, sizeof(word));
+        }
+    }
+}
+
+// --- Byte ring ---
+
+static void ring_write(rewind_buffer_t* rewind, const uint8_t* src, size_t length) {
+    size_t first = rewind->capacity - rewind->write;
+    if (first > length)
+        first = length;
+    memcpy(rewind->data + rewind->write, src, first);
+    memcpy(rewind->data, src + first, length - first);
+    rewind->write = (rewind->write + length) % rewind->capacity;
+    rewind->used += length;
+}
+
+static void ring_read(const rewind_buffer_t* rewind, size_t offset, uint8_t* dst, size_t length) {
+    size_t first = rewind->capacity - offset;
+    if (first > length)
+        first = length;
+    memcpy(dst, rewind->data + offset, first);
+    memcpy(dst + first, rewind->data, length - first);
+}
+
+static inline rewind_entry_t* entry_at(const rewind_buffer_t* rewind, uint64_t seq) {
+    return &rewind->entries[seq % rewind->max_frames];
+}
+
+// Drops the oldest frame and every delta that depended on it
+static void evict_oldest(rewind_buffer_t* rewind) {
+    do {
+        rewind->used -= entry_at(rewind, rewind->first_seq)->length;
+        rewind->first_seq++;
+    } while (rewind->first_seq < rewind->next_seq
+             && entry_at(rewind, rewind->first_seq)->keyframe_seq != rewind->first_seq);
+}
+
+// Makes rewind->keyframe the decoded keyframe seq. Uses scratch.
+static void cache_keyframe(rewind_buffer_t* rewind, uint64_t seq) {
+    if (rewind->keyframe_valid && rewind->cached_keyframe_seq == seq)
+        return;
+    const rewind_entry_t* entry = entry_at(rewind, seq);
+    ring_read(rewind, entry->offset, rewind->scratch, entry->length);
+    delta_decode(rewind->scratch, entry->length, NULL, &rewind->keyframe);
+    rewind->cached_keyframe_seq = seq;
+    rewind->keyframe_valid = true;
+}
+
+rewind_buffer_t* rewind_create(uint32_t max_frames, size_t budget_bytes) {
+    if (max_frames < 2)
+        max_frames = 2;
+    if (budget_bytes < MIN_BUDGET_BYTES)
+        budget_bytes = MIN_BUDGET_BYTES;
+    rewind_buffer_t* rewind = calloc(1, sizeof(*rewind));
+    if (!rewind)
+        return NULL;
+    rewind->data = malloc(budget_bytes);
+    rewind->entries = calloc(max_frames, sizeof(rewind_entry_t));
+    if (!rewind->data || !rewind->entries) {
+        fprintf(stderr, "Error: Could not allocate %zu bytes of rewind history\n", budget_bytes);
+        rewind_destroy(rewind);
+        return NULL;
+    }
+    rewind->capacity = budget_bytes;
+    rewind->max_frames = max_frames;
+    return rewind;
+}
+
+void rewind_destroy(rewind_buffer_t* rewind) {
+    if (!rewind)
+        return;
+    free(rewind->data);
+    free(rewind->entries);
+    free(rewind);
+}
+
+void rewind_push(rewind_buffer_t* rewind, const chip8_t* chip8) {
+    snapshot_state_t state;
+    snapshot_capture(chip8, &state);
+
+    uint64_t seq = rewind->next_seq;
+    uint64_t keyframe_seq = seq;
+    if (rewind->next_seq > rewind->first_seq) {
+        uint64_t newest_keyframe = entry_at(rewind, seq - 1)->keyframe_seq;
+        if (seq - newest_keyframe < REWIND_KEYFRAME_INTERVAL)
+            keyframe_seq = newest_keyframe;
+    }
+
+    size_t length;
+    for (;;) {
+        bool keyframe = keyframe_seq == seq;
+        if (!keyframe)
+            cache_keyframe(rewind, keyframe_seq);
+        length = delta_encode(&state, keyframe ? NULL : &rewind->keyframe, rewind->scratch);
+        while (rewind->next_seq > rewind->first_seq
+               && (rewind->next_seq - rewind->first_seq >= rewind->max_frames
+                   || rewind->capacity - rewind->used < length))
+            evict_oldest(rewind);
+        // Making room evicted the keyframe this delta was against: store a keyframe instead
+        if (keyframe || keyframe_seq >= rewind->first_seq)
+            break;
+        keyframe_seq = seq;
+    }
+
+    rewind_entry_t* entry = entry_at(rewind, seq);
+    entry->offset = rewind->write;
+    entry->length = (uint32_t)length;
+    entry->keyframe_seq = keyframe_seq;
+    ring_write(rewind, rewind->scratch, length);
+    rewind->next_seq++;
+    if (keyframe_seq == seq) {
+        rewind->keyframe = state;
+        rewind->cached_keyframe_seq = seq;
+        rewind->keyframe_valid = true;
+    }
+}
+
+int rewind_step_back(rewind_buffer_t* rewind, chip8_t* chip8) {
+    if (rewind->next_seq - rewind->first_seq < 2)
+        return 1;
+
+    // Drop the newest frame, the bytes it used are the last ones written
+    uint64_t newest = --rewind->next_seq;
+    const rewind_entry_t* dropped = entry_at(rewind, newest);
+    rewind->write = dropped->offset;
+    rewind->used -= dropped->length;
+    if (rewind->keyframe_valid && rewind->cached_keyframe_seq == newest)
+        rewind->keyframe_valid = false; // its sequence number will be reused
+
+    uint64_t seq = newest - 1;
+    const rewind_entry_t* entry = entry_at(rewind, seq);
+    snapshot_state_t state;
+    if (entry->keyframe_seq == seq) {
+        ring_read(rewind, entry->offset, rewind->scratch, entry->length);
+        delta_decode(rewind->scratch, entry->length, NULL, &state);
+    } else {
+        cache_keyframe(rewind, entry->keyframe_seq);
+        ring_read(rewind, entry->offset, rewind->scratch, entry->length);
+        delta_decode(rewind->scratch, entry->length, &rewind->keyframe, &state);
+    }
+    return snapshot_restore(chip8, &state);
+}
+
+uint32_t rewind_frames(const rewind_buffer_t* rewind) {
+    return (uint32_t)(rewind->next_seq - rewind->first_seq);
+}
+
+size_t rewind_bytes_used(const rewind_buffer_t* rewind) {
+    return rewind->used;
+}
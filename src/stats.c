@@ -0,0 +1,295 @@
+#define _POSIX_C_SOURCE 200809L
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <pthread.h>
+
+#define SOCKET_PREFIX "unix:"
+#define SUB_BUCKET_BITS 2 // four buckets per power of two
+#define SNAPSHOT_MAX 16384
+
+struct stats_exporter {
+    pthread_mutex_t lock;              // guards everything below but the export target
+    const char* const* phase_names;
+    int phase_count;
+    latency_histogram_t* interval;     // phase_count phases, then the busy time of the whole iteration
+    uint64_t* total_max_ns;            // per phase and busy, since the start
+    uint64_t frames, overruns, late_frames;
+    uint64_t interval_frames, interval_overruns, interval_late_frames;
+    uint64_t start_ns, interval_start_ns, interval_start_cycles;
+    uint64_t snapshots, dropped_snapshots;
+
+    char* path;                        // file target, or the socket path
+    char* temp_path;
+    bool socket;
+    int fd;                            // connected socket, or -1
+    char buffer[SNAPSHOT_MAX];
+};
+
+// Values below 4 ns get a bucket each; above that, the top three significant bits pick the bucket
+static int bucket_index(uint64_t ns) {
+    if (ns < (1u << SUB_BUCKET_BITS))
+        return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (msb - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+    return (msb << SUB_BUCKET_BITS) + sub;
+}
+
+static uint64_t bucket_upper_bound(int index) {
+    if (index < (1 << SUB_BUCKET_BITS))
+        return (uint64_t)index;
+    int msb = index >> SUB_BUCKET_BITS;
+    uint64_t sub = (uint64_t)(index & ((1 << SUB_BUCKET_BITS) - 1));
+    uint64_t width = 1ull << (msb - SUB_BUCKET_BITS);
+    return (((1ull << SUB_BUCKET_BITS) + sub) * width) + (width - 1);
+}
+
+void histogram_record(latency_histogram_t* histogram, uint64_t ns) {
+    histogram->buckets[bucket_index(ns)]++;
+    histogram->count++;
+    histogram->sum_ns += ns;
+    if (ns > histogram->max_ns)
+        histogram->max_ns = ns;
+}
+
+uint64_t histogram_percentile(const latency_histogram_t* histogram, double fraction) {
+    if (histogram->count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(fraction * histogram->count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint64_t bound = bucket_upper_bound(i);
+            return bound < histogram->max_ns ? bound : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+static char* copy_string(const char* s) {
+    char* copy = malloc(strlen(s) + 1);
+    if (copy)
+        strcpy(copy, s);
+    return copy;
+}
+
+static void stats_free(stats_exporter_t* stats) {
+    pthread_mutex_destroy(&stats->lock);
+    if (stats->fd >= 0)
+        close(stats->fd);
+    free(stats->interval);
+    free(stats->total_max_ns);
+    free(stats->path);
+    free(stats->temp_path);
+    free(stats);
+}
+
+// Non-blocking, so a reader that stops draining the socket costs snapshots, not frames
+static void socket_connect(stats_exporter_t* stats) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return;
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, stats->path);
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0
+        || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+        close(fd);
+        return;
+    }
+    stats->fd = fd;
+}
+
+stats_exporter_t* stats_open(const char* target, const char* const phase_names[], int phase_count) {
+    stats_exporter_t* stats = calloc(1, sizeof(*stats));
+    if (!stats) {
+        fprintf(stderr, "Error: Could not allocate the host statistics\n");
+        return NULL;
+    }
+    stats->fd = -1;
+    pthread_mutex_init(&stats->lock, NULL);
+    stats->phase_names = phase_names;
+    stats->phase_count = phase_count;
+    stats->interval = calloc(phase_count + 1, sizeof(*stats->interval));
+    stats->total_max_ns = calloc(phase_count + 1, sizeof(*stats->total_max_ns));
+    stats->socket = strncmp(target, SOCKET_PREFIX, strlen(SOCKET_PREFIX)) == 0;
+    stats->path = copy_string(stats->socket ? target + strlen(SOCKET_PREFIX) : target);
+    if (!stats->interval || !stats->total_max_ns || !stats->path) {
+        fprintf(stderr, "Error: Could not allocate the host statistics\n");
+        stats_free(stats);
+        return NULL;
+    }
+
+    if (stats->socket) {
+        if (stats->path[0] == '\0' || strlen(stats->path) >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+            fprintf(stderr, "Error: Invalid statistics socket path %s\n", target);
+            stats_free(stats);
+            return NULL;
+        }
+        // A reader that disconnects must not kill the emulator
+        signal(SIGPIPE, SIG_IGN);
+        socket_connect(stats);
+        if (stats->fd < 0)
+            fprintf(stderr, "Error: Could not connect to %s (%s), retrying every snapshot\n", stats->path, strerror(errno));
+    } else {
+        stats->temp_path = malloc(strlen(stats->path) + 5);
+        if (!stats->temp_path) {
+            fprintf(stderr, "Error: Could not allocate the host statistics\n");
+            stats_free(stats);
+            return NULL;
+        }
+        sprintf(stats->temp_path, "%s.tmp", stats->path);
+    }
+    return stats;
+}
+
+// Index phase_count is the busy time of the emulation loop. Called with the lock held.
+static void record(stats_exporter_t* stats, int phase, uint64_t ns) {
+    histogram_record(&stats->interval[phase], ns);
+    if (ns > stats->total_max_ns[phase])
+        stats->total_max_ns[phase] = ns;
+}
+
+void stats_record_phase(stats_exporter_t* stats, int phase, uint64_t ns) {
+    if (!stats)
+        return;
+    pthread_mutex_lock(&stats->lock);
+    record(stats, phase, ns);
+    pthread_mutex_unlock(&stats->lock);
+}
+
+void stats_record_frame(stats_exporter_t* stats, uint64_t busy_ns, uint64_t budget_ns, uint32_t late_frames) {
+    if (!stats)
+        return;
+    bool overrun = busy_ns > budget_ns;
+    pthread_mutex_lock(&stats->lock);
+    record(stats, stats->phase_count, busy_ns);
+    stats->frames++;
+    stats->interval_frames++;
+    stats->overruns += overrun;
+    stats->interval_overruns += overrun;
+    stats->late_frames += late_frames;
+    stats->interval_late_frames += late_frames;
+    pthread_mutex_unlock(&stats->lock);
+}
+
+// Appends to the snapshot buffer, keeping count of the space used
+__attribute__((format(printf, 3, 4)))
+static void append(stats_exporter_t* stats, size_t* used, const char* format, ...) {
+    if (*used >= sizeof(stats->buffer))
+        return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(stats->buffer + *used, sizeof(stats->buffer) - *used, format, args);
+    va_end(args);
+    *used += n > 0 ? (size_t)n : 0;
+}
+
+static size_t format_snapshot(stats_exporter_t* stats, uint64_t now_ns, uint64_t cycles) {
+    double interval_s = (now_ns - stats->interval_start_ns) / 1e9;
+    size_t used = 0;
+    append(stats, &used,
+           "{\"uptime_s\":%.3f,\"interval_s\":%.3f,\"cycles\":%" PRIu64 ",\"mips\":%.3f,"
+           "\"frames\":%" PRIu64 ",\"overruns\":%" PRIu64 ",\"late_frames\":%" PRIu64 ","
+           "\"interval\":{\"frames\":%" PRIu64 ",\"overruns\":%" PRIu64 ",\"late_frames\":%" PRIu64 ",\"phases\":{",
+           (now_ns - stats->start_ns) / 1e9, interval_s, cycles,
+           interval_s > 0 ? (cycles - stats->interval_start_cycles) / interval_s / 1e6 : 0.0,
+           stats->frames, stats->overruns,
+           stats->late_frames, stats->interval_frames,
+           stats->interval_overruns, stats->interval_late_frames);
+    for (int i = 0; i <= stats->phase_count; i++) {
+        const latency_histogram_t* h = &stats->interval[i];
+        append(stats, &used, "%s\"%s\":{\"count\":%" PRIu64 ",\"mean_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+               i ? "," : "", i < stats->phase_count ? stats->phase_names[i] : "busy",
+               h->count, h->count ? h->sum_ns / 1e3 / h->count : 0.0,
+               histogram_percentile(h, 0.50) / 1e3, histogram_percentile(h, 0.99) / 1e3, h->max_ns / 1e3);
+    }
+    append(stats, &used, "}},\"max_us\":{");
+    for (int i = 0; i <= stats->phase_count; i++)
+        append(stats, &used, "%s\"%s\":%.3f", i ? "," : "",
+               i < stats->phase_count ? stats->phase_names[i] : "busy", stats->total_max_ns[i] / 1e3);
+    append(stats, &used, "},\"dropped_snapshots\":%" PRIu64 "}\n", stats->dropped_snapshots);
+    return used < sizeof(stats->buffer) ? used : 0;
+}
+
+static bool write_file(stats_exporter_t* stats, size_t length) {
+    FILE* file = fopen(stats->temp_path, "w");
+    if (!file)
+        return false;
+    bool ok = fwrite(stats->buffer, 1, length, file) == length;
+    ok = (fclose(file) == 0) && ok;
+    return ok && rename(stats->temp_path, stats->path) == 0;
+}
+
+// A snapshot is one line; a partial write would corrupt the stream, so it drops the connection
+static bool write_socket(stats_exporter_t* stats, size_t length) {
+    if (stats->fd < 0)
+        socket_connect(stats);
+    if (stats->fd < 0)
+        return false;
+    ssize_t written = write(stats->fd, stats->buffer, length);
+    if (written == (ssize_t)length)
+        return true;
+    if (written >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        close(stats->fd);
+        stats->fd = -1;
+    }
+    return false;
+}
+
+void stats_export(stats_exporter_t* stats, uint64_t now_ns, uint64_t cycles, bool force) {
+    if (!stats)
+        return;
+    if (stats->start_ns == 0) {
+        // First call starts the clock
+        stats->start_ns = stats->interval_start_ns = now_ns;
+        stats->interval_start_cycles = cycles;
+        if (!force)
+            return;
+    }
+    if (!force && now_ns - stats->interval_start_ns < STATS_INTERVAL_NS)
+        return;
+
+    pthread_mutex_lock(&stats->lock);
+    size_t length = format_snapshot(stats, now_ns, cycles);
+    memset(stats->interval, 0, (stats->phase_count + 1) * sizeof(*stats->interval));
+    stats->interval_frames = stats->interval_overruns = stats->interval_late_frames = 0;
+    stats->interval_start_ns = now_ns;
+    stats->interval_start_cycles = cycles;
+    pthread_mutex_unlock(&stats->lock);
+
+    // The slow part runs unlocked, the buffer and target belong to the exporting thread
+    bool ok = length > 0 && (stats->socket ? write_socket(stats, length) : write_file(stats, length));
+    if (ok)
+        stats->snapshots++;
+    else
+        stats->dropped_snapshots++;
+}
+
+void stats_close(stats_exporter_t* stats, uint64_t now_ns, uint64_t cycles) {
+    if (!stats)
+        return;
+    // The last periodic snapshot may already cover everything
+    if (stats->interval_frames > 0 || stats->snapshots + stats->dropped_snapshots == 0)
+        stats_export(stats, now_ns, cycles, true);
+    printf("Host statistics: %" PRIu64 " frames, %" PRIu64 " over budget, %" PRIu64 " late; %" PRIu64 " snapshots to %s%s",
+           stats->frames, stats->overruns,
+           stats->late_frames, stats->snapshots,
+           stats->socket ? SOCKET_PREFIX : "", stats->path);
+    if (stats->dropped_snapshots)
+        printf(" (%" PRIu64 " dropped)", stats->dropped_snapshots);
+    printf("\n");
+    stats_free(stats);
+}
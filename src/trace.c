@@ -0,0 +1,122 @@
+#define _POSIX_C_SOURCE 200809L
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*
+    Double-buffered trace writer.
+    The emulator fills the active buffer without taking any lock. When it is
+    full the buffers are swapped and the background thread writes the full one
+    to disk while the emulator keeps filling the other. Records are written in
+    host byte order.
+*/
+struct trace_writer {
+    FILE* file;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    trace_record_t buffers[2][TRACE_BUFFER_RECORDS];
+    int active;     // buffer currently filled by the emulator
+    size_t fill;    // records in the active buffer
+    size_t pending; // records in the other buffer waiting for the writer, 0 when it is free
+    bool stopping;
+};
+
+static void* trace_writer_thread(void* arg) {
+    trace_writer_t* writer = arg;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (writer->pending == 0 && !writer->stopping)
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        if (writer->pending == 0)
+            break; // stopping and nothing left to write
+
+        // The emulator never touches the pending buffer, so write it unlocked
+        size_t count = writer->pending;
+        trace_record_t* buffer = writer->buffers[!writer->active];
+        pthread_mutex_unlock(&writer->lock);
+        fwrite(buffer, sizeof(trace_record_t), count, writer->file);
+        pthread_mutex_lock(&writer->lock);
+
+        writer->pending = 0;
+        pthread_cond_broadcast(&writer->cond);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+static void trace_writer_swap(trace_writer_t* writer) {
+    pthread_mutex_lock(&writer->lock);
+    while (writer->pending != 0)
+        pthread_cond_wait(&writer->cond, &writer->lock);
+    writer->pending = writer->fill;
+    writer->active = !writer->active;
+    writer->fill = 0;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+trace_writer_t* trace_writer_open(const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open trace file %s\n", filename);
+        return NULL;
+    }
+
+    trace_file_header_t header = { .version = TRACE_VERSION, .record_size = sizeof(trace_record_t) };
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, file);
+
+    trace_writer_t* writer = calloc(1, sizeof(trace_writer_t));
+    if (!writer) {
+        fclose(file);
+        return NULL;
+    }
+    writer->file = file;
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+
+    if (pthread_create(&writer->thread, NULL, trace_writer_thread, writer) != 0) {
+        fprintf(stderr, "Error: Could not start trace writer thread\n");
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->cond);
+        fclose(file);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void trace_writer_push(trace_writer_t* writer, const trace_record_t* record) {
+    writer->buffers[writer->active][writer->fill++] = *record;
+    if (writer->fill == TRACE_BUFFER_RECORDS)
+        trace_writer_swap(writer);
+}
+
+void trace_writer_close(trace_writer_t* writer) {
+    if (!writer)
+        return;
+    if (writer->fill > 0)
+        trace_writer_swap(writer);
+
+    pthread_mutex_lock(&writer->lock);
+    writer->stopping = true;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->cond);
+    fclose(writer->file);
+    free(writer);
+}
+
+void trace_print_record(FILE* out, const trace_record_t* record) {
+    fprintf(out, "[0x%4X] 0x%4X | V0-VF[", record->pc, record->opcode);
+    for (int i = 0; i < 16; i++)
+        fprintf(out, "%02X ", record->V[i]);
+    fprintf(out, "]\n");
+}
@@ -0,0 +1,436 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "chip8.h"
+
+/*
+    Golden-display conformance suite, run by make test.
+
+    Each case runs a ROM headless from power-on for a fixed number of cycles
+    with one quirk configuration, hashes the final display with
+    chip8_display_hash and compares it with the golden value in the case
+    list. A case whose hash differs (or has no golden value yet) fails and
+    its framebuffer is written as a PBM image to the output directory, so it
+    can be looked at and, if it is right, recorded with make test-update.
+    ROMs missing from the ROM directory are skipped, they are not part of
+    the tree (see docs/TESTING.md). A run in which every case was skipped
+    fails unless --allow-missing is given, so the suite cannot pass without
+    checking anything.
+
+    Case list: one case per line, '#' starts a comment:
+        <rom file> <none|legacy> <cycles> <display hash, or - if not recorded>
+    A ROM name with a directory part (e.g. synthetic/digits-alu.ch8) is
+    relative to the case list and ships with it; bare names are looked up
+    in the ROM directory.
+
+    Cases run concurrently, one per worker, and each reports the cycles it
+    executed and its wall time, so the suite doubles as a performance check
+    of the DISPATCH core it was built with.
+*/
+
+#define MAX_LINE 1024
+#define CASE_SEED 1 // none of the cases may depend on it, but runs must be reproducible
+
+typedef enum { CASE_PASS, CASE_FAIL, CASE_NEW, CASE_SKIP, CASE_ERROR } case_result_t;
+
+typedef struct {
+    // From the case list
+    char* rom;
+    bool legacy;
+    uint64_t cycles;
+    bool has_golden;
+    uint64_t golden;
+    int line_number;
+    // Results
+    case_result_t result;
+    uint64_t cycles_run;
+    uint64_t display_hash;
+    uint64_t wall_ns;
+    char image_path[MAX_LINE];
+} test_case_t;
+
+typedef struct {
+    test_case_t* cases;
+    size_t count;
+    size_t next;
+    pthread_mutex_t lock;
+    const char* rom_dir;
+    const char* output_dir;
+    char list_dir[MAX_LINE];  // directory of the case list, for ROMs that ship with it
+} suite_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [options] <case_list>\n", prog_name);
+    fprintf(stderr, "\nOptions:\n");
+    fprintf(stderr, "  -h, --help          Show this help message and exit\n");
+    fprintf(stderr, "  -j, --jobs <n>      Worker threads (default: one per online CPU)\n");
+    fprintf(stderr, "  -r, --roms <dir>    Directory holding the ROMs (default: tests/roms)\n");
+    fprintf(stderr, "  -o, --output <dir>  Where PBM images of failing cases go (default: build/test_output)\n");
+    fprintf(stderr, "  -u, --update        Record the current hashes as the golden values in <case_list>\n");
+    fprintf(stderr, "      --allow-missing Succeed even if no ROM was found and every case was skipped\n");
+}
+
+// --- Case list ---
+
+static int parse_case(char* line, int line_number, test_case_t* test) {
+    memset(test, 0, sizeof(*test));
+    test->line_number = line_number;
+    char* fields[4];
+    int count = 0;
+    for (char* token = strtok(line, " \t\r\n"); token; token = strtok(NULL, " \t\r\n")) {
+        if (count == 4) {
+            count++;
+            break;
+        }
+        fields[count++] = token;
+    }
+    char* end = NULL;
+    if (count != 4) {
+        fprintf(stderr, "Error: case list line %d: expected <rom> <quirks> <cycles> <hash>\n", line_number);
+        return -1;
+    }
+    if (strcmp(fields[1], "legacy") != 0 && strcmp(fields[1], "none") != 0) {
+        fprintf(stderr, "Error: case list line %d: quirks must be legacy or none\n", line_number);
+        return -1;
+    }
+    test->legacy = strcmp(fields[1], "legacy") == 0;
+    test->cycles = strtoull(fields[2], &end, 0);
+    if (fields[2][0] == '-' || *end != '\0' || test->cycles == 0) {
+        fprintf(stderr, "Error: case list line %d: invalid cycle count %s\n", line_number, fields[2]);
+        return -1;
+    }
+    if (strcmp(fields[3], "-") != 0) {
+        test->golden = strtoull(fields[3], &end, 16);
+        if (*end != '\0') {
+            fprintf(stderr, "Error: case list line %d: invalid hash %s\n", line_number, fields[3]);
+            return -1;
+        }
+        test->has_golden = true;
+    }
+    test->rom = strdup(fields[0]);
+    return test->rom ? 0 : -1;
+}
+
+static test_case_t* load_cases(const char* path, size_t* count) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open case list %s\n", path);
+        return NULL;
+    }
+
+    test_case_t* cases = NULL;
+    size_t capacity = 0;
+    *count = 0;
+    char line[MAX_LINE];
+    int line_number = 0;
+    bool failed = false;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+        if (strspn(line, " \t\r\n") == strlen(line))
+            continue;
+
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            test_case_t* grown = realloc(cases, capacity * sizeof(test_case_t));
+            if (!grown) {
+                fprintf(stderr, "Error: Out of memory reading the case list\n");
+                failed = true;
+                break;
+            }
+            cases = grown;
+        }
+        if (parse_case(line, line_number, &cases[*count]) != 0) {
+            failed = true;
+            break;
+        }
+        (*count)++;
+    }
+    fclose(file);
+    if (!failed && *count == 0) {
+        fprintf(stderr, "Error: Case list %s has no cases\n", path);
+        failed = true;
+    }
+    if (failed) {
+        for (size_t i = 0; i < *count; i++)
+            free(cases[i].rom);
+        free(cases);
+        return NULL;
+    }
+    return cases;
+}
+
+/*
+    Rewrites the hash column of every case that ran, keeping comments and
+    the other columns as they are. Written to a temporary file first, so an
+    error leaves the old list intact.
+*/
+static int update_cases(const char* path, const test_case_t* cases, size_t count) {
+    char temp_path[MAX_LINE];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* in = fopen(path, "r");
+    FILE* out = fopen(temp_path, "w");
+    if (!in || !out) {
+        fprintf(stderr, "Error: Could not rewrite case list %s\n", path);
+        if (in)
+            fclose(in);
+        if (out)
+            fclose(out);
+        return 1;
+    }
+
+    char line[MAX_LINE];
+    int line_number = 0;
+    size_t next = 0;
+    while (fgets(line, sizeof(line), in)) {
+        line_number++;
+        if (next < count && cases[next].line_number == line_number) {
+            const test_case_t* test = &cases[next++];
+            if (test->result != CASE_SKIP && test->result != CASE_ERROR) {
+                fprintf(out, "%-24s %-7s %-9" PRIu64 " %016" PRIx64 "\n",
+                        test->rom, test->legacy ? "legacy" : "none", test->cycles, test->display_hash);
+                continue;
+            }
+        }
+        fputs(line, out);
+    }
+    fclose(in);
+    bool ok = fclose(out) == 0;
+    if (!ok || rename(temp_path, path) != 0) {
+        fprintf(stderr, "Error: Could not rewrite case list %s\n", path);
+        remove(temp_path);
+        return 1;
+    }
+    return 0;
+}
+
+// --- Running cases ---
+
+// P4 bitmap, whose rows are the display rows most significant bit first, exactly like chip8_t.display
+static int write_pbm(const char* path, const uint64_t display[DISPLAY_HEIGHT]) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not write %s\n", path);
+        return 1;
+    }
+    fprintf(file, "P4\n%d %d\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        uint8_t row[DISPLAY_WIDTH / 8];
+        for (int b = 0; b < DISPLAY_WIDTH / 8; b++)
+            row[b] = (uint8_t)(display[y] >> (DISPLAY_WIDTH - 8 - 8 * b));
+        fwrite(row, 1, sizeof(row), file);
+    }
+    return fclose(file) == 0 ? 0 : 1;
+}
+
+static void run_case(const suite_t* suite, test_case_t* test) {
+    char rom_path[2 * MAX_LINE];
+    snprintf(rom_path, sizeof(rom_path), "%s/%s", strchr(test->rom, '/') ? suite->list_dir : suite->rom_dir, test->rom);
+    FILE* rom_file = fopen(rom_path, "rb");
+    if (!rom_file) {
+        test->result = CASE_SKIP;
+        return;
+    }
+    uint8_t program[MEMORY_SIZE];
+    size_t size = fread(program, 1, sizeof(program), rom_file);
+    fclose(rom_file);
+
+    uint64_t start = now_ns();
+    chip8_config config = {0};
+    config.legacy_mode = test->legacy;
+    config.seed = CASE_SEED;
+    config.trace_level = TRACE_OFF;
+    // chip8_t is too large for a worker's stack with the predecoded core
+    chip8_t* chip8 = malloc(sizeof(chip8_t));
+    if (!chip8) {
+        test->result = CASE_ERROR;
+        return;
+    }
+    chip8_initialize(chip8, &config);
+    if (chip8_load_program(chip8, program, size) != 0) {
+        chip8_shutdown(chip8);
+        free(chip8);
+        test->result = CASE_ERROR;
+        return;
+    }
+    // Same scheduling as the emulator: stop at every timer tick
+    while (chip8->cycles < test->cycles) {
+        uint64_t run = chip8_cycles_until_tick(chip8);
+        if (test->cycles - chip8->cycles < run)
+            run = test->cycles - chip8->cycles;
+        chip8_run_cycles(chip8, (uint32_t)run);
+        while (chip8_cycles_until_tick(chip8) == 0)
+            update_timers(chip8);
+    }
+    test->wall_ns = now_ns() - start;
+    test->cycles_run = chip8->cycles;
+    test->display_hash = chip8_display_hash(chip8->display);
+
+    if (!test->has_golden)
+        test->result = CASE_NEW;
+    else
+        test->result = test->display_hash == test->golden ? CASE_PASS : CASE_FAIL;
+    // The ROM name without directories or extension, e.g. 3-corax+
+    const char* name = strrchr(test->rom, '/') ? strrchr(test->rom, '/') + 1 : test->rom;
+    int length = strrchr(name, '.') ? (int)(strrchr(name, '.') - name) : (int)strlen(name);
+    snprintf(test->image_path, sizeof(test->image_path), "%s/%.*s-%s.pbm",
+             suite->output_dir, length, name, test->legacy ? "legacy" : "none");
+    if (test->result == CASE_PASS) {
+        // Drop the image of an earlier failure, what is left in the output directory still needs looking at
+        remove(test->image_path);
+        test->image_path[0] = '\0';
+    } else if (write_pbm(test->image_path, chip8->display) != 0) {
+        test->image_path[0] = '\0';
+    }
+    chip8_shutdown(chip8);
+    free(chip8);
+}
+
+static void* worker_main(void* arg) {
+    suite_t* suite = arg;
+    for (;;) {
+        pthread_mutex_lock(&suite->lock);
+        size_t index = suite->next++;
+        pthread_mutex_unlock(&suite->lock);
+        if (index >= suite->count)
+            return NULL;
+        run_case(suite, &suite->cases[index]);
+    }
+}
+
+static void print_results(const test_case_t* cases, size_t count) {
+    static const char* labels[] = { "PASS", "FAIL", "NEW", "SKIP", "ERROR" };
+    for (size_t i = 0; i < count; i++) {
+        const test_case_t* test = &cases[i];
+        printf("%-5s %-24s %-7s", labels[test->result], test->rom, test->legacy ? "legacy" : "none");
+        if (test->result == CASE_SKIP) {
+            printf(" ROM not found\n");
+            continue;
+        }
+        if (test->result == CASE_ERROR) {
+            printf(" could not load the ROM\n");
+            continue;
+        }
+        printf(" %10" PRIu64 " cycles %8.3f ms %8.2f MIPS  hash %016" PRIx64,
+               test->cycles_run, test->wall_ns / 1e6,
+               test->wall_ns ? test->cycles_run / (test->wall_ns / 1e3) : 0.0, test->display_hash);
+        if (test->result == CASE_FAIL)
+            printf(" expected %016" PRIx64, test->golden);
+        if (test->image_path[0])
+            printf(" -> %s", test->image_path);
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+    bool update = false;
+    bool allow_missing = false;
+    suite_t suite = { .rom_dir = "tests/roms", .output_dir = "build/test_output" };
+
+    static struct option long_options[] = {
+        {"help",   no_argument,       0, 'h'},
+        {"jobs",   required_argument, 0, 'j'},
+        {"roms",   required_argument, 0, 'r'},
+        {"output", required_argument, 0, 'o'},
+        {"update", no_argument,       0, 'u'},
+        {"allow-missing", no_argument, 0, 'a'},
+        {0, 0, 0, 0}
+    };
+    int opt_char;
+    while ((opt_char = getopt_long(argc, argv, "hj:r:o:u", long_options, NULL)) != -1) {
+        switch (opt_char) {
+            case 'h': print_usage(argv[0]); return 0;
+            case 'j': worker_count = atol(optarg); break;
+            case 'r': suite.rom_dir = optarg; break;
+            case 'o': suite.output_dir = optarg; break;
+            case 'u': update = true; break;
+            case 'a': allow_missing = true; break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Error: Missing required case list argument.\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char* list_path = argv[optind];
+    const char* slash = strrchr(list_path, '/');
+    snprintf(suite.list_dir, sizeof(suite.list_dir), "%.*s",
+             slash ? (int)(slash - list_path) : 1, slash ? list_path : ".");
+    suite.cases = load_cases(list_path, &suite.count);
+    if (!suite.cases)
+        return 1;
+    if (worker_count < 1)
+        worker_count = 1;
+    if ((size_t)worker_count > suite.count)
+        worker_count = (long)suite.count;
+    mkdir(suite.output_dir, 0755);
+    pthread_mutex_init(&suite.lock, NULL);
+
+    pthread_t* threads = calloc(worker_count, sizeof(pthread_t));
+    if (!threads) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    uint64_t start = now_ns();
+    int started = 0;
+    for (; started < worker_count; started++) {
+        if (pthread_create(&threads[started], NULL, worker_main, &suite) != 0) {
+            fprintf(stderr, "Error: Could not start worker %d\n", started);
+            break;
+        }
+    }
+    if (started == 0)
+        worker_main(&suite);
+    for (int w = 0; w < started; w++)
+        pthread_join(threads[w], NULL);
+    uint64_t elapsed = now_ns() - start;
+
+    print_results(suite.cases, suite.count);
+    size_t tally[CASE_ERROR + 1] = {0};
+    uint64_t total_cycles = 0;
+    for (size_t i = 0; i < suite.count; i++) {
+        tally[suite.cases[i].result]++;
+        total_cycles += suite.cases[i].cycles_run;
+    }
+    printf("%zu cases: %zu passed, %zu failed, %zu new, %zu skipped, %zu errors in %.3f s on %d workers, %.2f MIPS aggregate\n",
+           suite.count, tally[CASE_PASS], tally[CASE_FAIL], tally[CASE_NEW], tally[CASE_SKIP], tally[CASE_ERROR],
+           elapsed / 1e9, started ? started : 1, elapsed ? total_cycles / (elapsed / 1e3) : 0.0);
+    bool none_ran = tally[CASE_SKIP] == suite.count;
+    if (none_ran)
+        printf("%s: 0 cases ran, no ROMs found in %s, see docs/TESTING.md\n",
+               allow_missing ? "Warning" : "Error", suite.rom_dir);
+
+    int status = 0;
+    if (update) {
+        status = update_cases(list_path, suite.cases, suite.count);
+        if (status == 0)
+            printf("Recorded %zu golden hashes in %s\n", suite.count - tally[CASE_SKIP] - tally[CASE_ERROR], list_path);
+    } else if (tally[CASE_FAIL] || tally[CASE_NEW] || tally[CASE_ERROR] || (none_ran && !allow_missing)) {
+        status = 1;
+    }
+
+    for (size_t i = 0; i < suite.count; i++)
+        free(suite.cases[i].rom);
+    free(suite.cases);
+    free(threads);
+    return status;
+}
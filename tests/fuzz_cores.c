@@ -0,0 +1,698 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "chip8.h"
+#include "lanes.h"
+#include "snapshot.h"
+
+/*
+    Differential fuzzer for the execution cores. Every input is a ROM plus an
+    initial machine state; it is run through the reference interpreter
+    (chip8_emulate_cycle, one instruction at a time through opcode_table) and
+    through each alternative core in this build:
+        - chip8_run_cycles, i.e. the DISPATCH core selected at build time
+          (table, threaded, predecoded or jit), scheduled like the host does
+        - the lockstep lane interpreter, with a second lane that diverges
+          (its keypad is inverted), checked against its own reference run
+    and the full snapshots of every lane are compared. On a mismatch the run is bisected to
+    the first divergent cycle and both register files are printed.
+
+    Input layout: FUZZ_HEADER_SIZE bytes of initial state (see fuzz_setup),
+    then the ROM, loaded at 0x200. Shorter inputs are zero-padded.
+
+    Build with make fuzz [DISPATCH=...]; run build/fuzz_cores -h for options.
+    With clang, make fuzz-libfuzzer builds the same checks as a libFuzzer
+    target instead (LLVMFuzzerTestOneInput, no main).
+*/
+
+#define FUZZ_HEADER_SIZE 32
+#define FUZZ_MAX_INPUT (FUZZ_HEADER_SIZE + MEMORY_SIZE - 0x200)
+#define LIBFUZZER_CYCLES 4096
+
+// Opcode kinds for the coverage map: pairs of consecutive kinds are the features
+#define KIND_COUNT 80
+#define COVERAGE_BITS (KIND_COUNT * KIND_COUNT)
+
+#if defined(CHIP8_JIT)
+#define DISPATCH_NAME "jit"
+#elif defined(CHIP8_PREDECODED_DISPATCH)
+#define DISPATCH_NAME "predecoded"
+#elif defined(CHIP8_THREADED_DISPATCH)
+#define DISPATCH_NAME "threaded"
+#else
+#define DISPATCH_NAME "table"
+#endif
+
+typedef struct {
+    const char* name;
+    // Runs chip8 (and partner, a second machine some cores need) from setup to cycles
+    void (*run)(chip8_t* chip8, chip8_t* partner, uint64_t cycles);
+    // The core runs partner too, with the keypad inverted; it is checked against its own reference run
+    bool partnered;
+} core_t;
+
+// --- Setup and the cores under test ---
+
+/*
+    Header bytes:
+        0-15  V0-VF          16-17 I (little endian, masked to 12 bits)
+        18    delay timer    19    sound timer
+        20-21 keypad bits    22    bit 0: legacy load/store quirk
+        23    clock rate selector, 60 + 37 * n Hz, so timer ticks fall at varied cycles
+        24-31 PRNG seed
+*/
+static void fuzz_setup(chip8_t* chip8, const uint8_t* data, size_t size) {
+    uint8_t header[FUZZ_HEADER_SIZE] = {0};
+    memcpy(header, data, size < FUZZ_HEADER_SIZE ? size : FUZZ_HEADER_SIZE);
+
+    chip8_config config = {0};
+    config.clock_rate = 60 + 37 * header[23];
+    config.legacy_mode = header[22] & 1;
+    memcpy(&config.seed, &header[24], sizeof(config.seed));
+    config.trace_level = TRACE_OFF;
+    chip8_initialize(chip8, &config);
+
+    if (size > FUZZ_HEADER_SIZE) {
+        size_t rom_size = size - FUZZ_HEADER_SIZE;
+        if (rom_size > MEMORY_SIZE - 0x200)
+            rom_size = MEMORY_SIZE - 0x200;
+        chip8_load_program(chip8, data + FUZZ_HEADER_SIZE, rom_size);
+    }
+    memcpy(chip8->V, header, NUM_REGISTERS);
+    chip8->I = (header[16] | (header[17] << 8)) & MEMORY_ADDRESS_MASK;
+    chip8->delay_timer = header[18];
+    chip8->sound_timer = header[19];
+    for (int key = 0; key < NUM_KEYS; key++)
+        chip8->keypad[key] = (header[20 + key / 8] >> (key % 8)) & 1;
+}
+
+static unsigned opcode_kind(uint16_t opcode) {
+    static const uint8_t fx_ops[] = { 0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x33, 0x55, 0x65 };
+    switch (opcode >> 12) {
+        case 0x0: return opcode == 0x00E0 ? 0 : opcode == 0x00EE ? 1 : 2;
+        case 0x8: return 16 + (opcode & 0x0F);
+        case 0xE: return 32 + ((opcode & 0xFF) == 0x9E ? 0 : (opcode & 0xFF) == 0xA1 ? 1 : 2);
+        case 0xF:
+            for (unsigned i = 0; i < sizeof(fx_ops); i++)
+                if ((opcode & 0xFF) == fx_ops[i])
+                    return 48 + i;
+            return 48 + sizeof(fx_ops);
+        default: return 64 + (opcode >> 12);
+    }
+}
+
+// The reference: one chip8_emulate_cycle at a time, timers delivered before each instruction they precede
+static void run_reference(chip8_t* chip8, uint64_t cycles, uint8_t* coverage) {
+    unsigned previous = 0;
+    while (chip8->cycles < cycles) {
+        while (chip8_cycles_until_tick(chip8) == 0)
+            update_timers(chip8);
+        if (coverage) {
+            uint16_t pc = chip8->pc & MEMORY_ADDRESS_MASK;
+            unsigned kind = opcode_kind((chip8->memory[pc] << 8) | chip8->memory[(pc + 1) & MEMORY_ADDRESS_MASK]);
+            coverage[previous * KIND_COUNT + kind] = 1;
+            previous = kind;
+        }
+        chip8_emulate_cycle(chip8);
+    }
+    while (chip8_cycles_until_tick(chip8) == 0)
+        update_timers(chip8);
+}
+
+static void run_dispatch(chip8_t* chip8, chip8_t* partner, uint64_t cycles) {
+    (void)partner;
+    while (chip8->cycles < cycles) {
+        uint64_t run = chip8_cycles_until_tick(chip8);
+        if (cycles - chip8->cycles < run)
+            run = cycles - chip8->cycles;
+        chip8_run_cycles(chip8, (uint32_t)run);
+        while (chip8_cycles_until_tick(chip8) == 0)
+            update_timers(chip8);
+    }
+}
+
+// partner holds the same input with the keypad inverted, so lanes split and regroup
+static void run_lanes(chip8_t* chip8, chip8_t* partner, uint64_t cycles) {
+    chip8_t* machines[2] = { chip8, partner };
+    chip8_lanes_t lanes;
+    if (chip8_lanes_init(&lanes, machines, 2) != 0)
+        abort();
+    chip8_lanes_run(&lanes, cycles);
+    chip8_lanes_sync(&lanes);
+}
+
+static const core_t cores[] = {
+    { DISPATCH_NAME, run_dispatch, false },
+    { "lanes", run_lanes, true },
+};
+#define CORE_COUNT (sizeof(cores) / sizeof(cores[0]))
+
+// --- Comparison ---
+
+typedef struct {
+    chip8_t* reference;
+    chip8_t* core;
+    chip8_t* partner;
+    chip8_t* partner_reference;
+} machines_t;
+
+static bool machines_alloc(machines_t* m) {
+    // chip8_t is too large for a thread's stack with the predecoded core
+    m->reference = malloc(sizeof(chip8_t));
+    m->core = malloc(sizeof(chip8_t));
+    m->partner = malloc(sizeof(chip8_t));
+    m->partner_reference = malloc(sizeof(chip8_t));
+    return m->reference && m->core && m->partner && m->partner_reference;
+}
+
+static void machines_free(machines_t* m) {
+    free(m->reference);
+    free(m->core);
+    free(m->partner);
+    free(m->partner_reference);
+}
+
+// Lane 0 is the input as given, lane 1 the partner with the keypad inverted
+static void lane_setup(chip8_t* chip8, const uint8_t* data, size_t size, int lane) {
+    fuzz_setup(chip8, data, size);
+    if (lane == 1) {
+        for (int key = 0; key < NUM_KEYS; key++)
+            chip8->keypad[key] = !chip8->keypad[key];
+    }
+}
+
+// Snapshots of one run, per lane: the reference's and the core's
+typedef struct {
+    snapshot_state_t expected[2];
+    snapshot_state_t actual[2];
+    int lanes; // 2 for partnered cores
+} run_result_t;
+
+static bool lane_matches(const run_result_t* result, int lane) {
+    return memcmp(&result->expected[lane], &result->actual[lane], sizeof(snapshot_state_t)) == 0;
+}
+
+/*
+    Runs input to cycles on the reference and on core (and, for partnered
+    cores, the partner lane against a second reference run with the same
+    inverted keypad). Returns true if every lane's snapshots match.
+*/
+static bool run_pair(machines_t* m, const core_t* core, const uint8_t* data, size_t size,
+                     uint64_t cycles, uint8_t* coverage, run_result_t* result) {
+    result->lanes = core->partnered ? 2 : 1;
+    lane_setup(m->reference, data, size, 0);
+    lane_setup(m->core, data, size, 0);
+    lane_setup(m->partner, data, size, core->partnered ? 1 : 0);
+    run_reference(m->reference, cycles, coverage);
+    if (core->partnered) {
+        lane_setup(m->partner_reference, data, size, 1);
+        run_reference(m->partner_reference, cycles, NULL);
+    }
+    core->run(m->core, m->partner, cycles);
+
+    snapshot_capture(m->reference, &result->expected[0]);
+    snapshot_capture(m->core, &result->actual[0]);
+    if (core->partnered) {
+        snapshot_capture(m->partner_reference, &result->expected[1]);
+        snapshot_capture(m->partner, &result->actual[1]);
+        chip8_shutdown(m->partner_reference);
+    }
+    chip8_shutdown(m->reference);
+    chip8_shutdown(m->core);
+    chip8_shutdown(m->partner);
+    for (int lane = 0; lane < result->lanes; lane++) {
+        if (!lane_matches(result, lane))
+            return false;
+    }
+    return true;
+}
+
+static void print_registers(FILE* out, const char* label, const snapshot_state_t* s) {
+    fprintf(out, "  %-10s PC=%03X I=%03X SP=%X DT=%02X ST=%02X cycles=%" PRIu64 " ticks=%" PRIu64 " V=",
+            label, s->pc, s->I, s->stack_pointer, s->delay_timer, s->sound_timer, s->cycles, s->timer_ticks);
+    for (int r = 0; r < NUM_REGISTERS; r++)
+        fprintf(out, "%02X", s->V[r]);
+    fprintf(out, "\n");
+}
+
+/*
+    Finds the first cycle after which core disagrees with the reference
+    (runs are deterministic, so a binary search over fresh runs works) and
+    prints the instruction executed there and both register files of the
+    first lane that diverged.
+*/
+static void report_divergence(FILE* out, machines_t* m, const core_t* core, const uint8_t* data, size_t size,
+                              uint64_t cycles) {
+    run_result_t result;
+    uint64_t good = 0, bad = cycles;
+    while (bad - good > 1) {
+        uint64_t mid = good + (bad - good) / 2;
+        if (run_pair(m, core, data, size, mid, NULL, &result))
+            good = mid;
+        else
+            bad = mid;
+    }
+    run_pair(m, core, data, size, bad, NULL, &result);
+    int lane = 0;
+    while (lane < result.lanes - 1 && lane_matches(&result, lane))
+        lane++;
+    const snapshot_state_t* expected = &result.expected[lane];
+    const snapshot_state_t* actual = &result.actual[lane];
+
+    snapshot_state_t before;
+    lane_setup(m->reference, data, size, lane);
+    run_reference(m->reference, good, NULL);
+    snapshot_capture(m->reference, &before);
+    chip8_shutdown(m->reference);
+
+    uint16_t pc = before.pc & MEMORY_ADDRESS_MASK;
+    uint16_t opcode = (before.memory[pc] << 8) | before.memory[(pc + 1) & MEMORY_ADDRESS_MASK];
+    fprintf(out, "DIVERGENCE in core '%s'%s at cycle %" PRIu64 ", executing %04X at %03X\n", core->name,
+            lane == 1 ? " (partner lane, keypad inverted)" : "", bad, opcode, pc);
+    print_registers(out, "reference", expected);
+    print_registers(out, core->name, actual);
+    bool registers = memcmp(expected->V, actual->V, sizeof(expected->V)) || expected->pc != actual->pc
+        || expected->I != actual->I || expected->stack_pointer != actual->stack_pointer
+        || expected->delay_timer != actual->delay_timer || expected->sound_timer != actual->sound_timer
+        || expected->cycles != actual->cycles || expected->timer_ticks != actual->timer_ticks;
+    fprintf(out, "  differs in:%s%s%s%s%s%s\n", registers ? " registers" : "",
+            memcmp(expected->memory, actual->memory, sizeof(expected->memory)) ? " memory" : "",
+            memcmp(expected->display, actual->display, sizeof(expected->display)) ? " display" : "",
+            memcmp(expected->stack, actual->stack, sizeof(expected->stack)) ? " stack" : "",
+            expected->rng_state != actual->rng_state ? " rng" : "",
+            expected->draw_flag != actual->draw_flag || expected->unknown_opcodes != actual->unknown_opcodes
+                ? " flags/counters" : "");
+}
+
+// Checks one input against every core. Returns the first divergent core, or NULL.
+static const core_t* check_input(machines_t* m, const uint8_t* data, size_t size, uint64_t cycles, uint8_t* coverage) {
+    for (size_t c = 0; c < CORE_COUNT; c++) {
+        run_result_t result;
+        if (!run_pair(m, &cores[c], data, size, cycles, c == 0 ? coverage : NULL, &result))
+            return &cores[c];
+    }
+    return NULL;
+}
+
+#ifdef CHIP8_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static machines_t m;
+    if (!m.reference && !machines_alloc(&m))
+        abort();
+    const core_t* core = check_input(&m, data, size, LIBFUZZER_CYCLES, NULL);
+    if (core) {
+        report_divergence(stderr, &m, core, data, size, LIBFUZZER_CYCLES);
+        abort();
+    }
+    return 0;
+}
+
+#else
+
+// --- Standalone parallel driver ---
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+} input_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    const char* corpus_dir;
+    uint64_t cycles;
+    uint64_t max_runs;      // 0: until the deadline
+    uint64_t deadline_ns;
+    uint64_t runs;
+    bool stop;
+    bool diverged;
+    uint8_t coverage[COVERAGE_BITS];
+    uint32_t features;
+    input_t* corpus;
+    size_t corpus_count;
+    size_t corpus_capacity;
+} fuzz_state_t;
+
+typedef struct {
+    fuzz_state_t* state;
+    uint64_t rng;
+} fuzz_worker_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t next_random(uint64_t* rng) {
+    uint64_t x = *rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *rng = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+static uint64_t input_hash(const uint8_t* data, size_t size) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static void write_input(const char* dir, const char* prefix, const uint8_t* data, size_t size, char* path, size_t path_size) {
+    snprintf(path, path_size, "%s/%s%016" PRIx64, dir, prefix, input_hash(data, size));
+    FILE* file = fopen(path, "wb");
+    if (!file || fwrite(data, 1, size, file) != size)
+        printf("Error: Could not write %s\n", path);
+    if (file)
+        fclose(file);
+}
+
+// Adds an input to the in-memory corpus. Caller holds the lock.
+static void corpus_add(fuzz_state_t* state, const uint8_t* data, size_t size) {
+    if (state->corpus_count == state->corpus_capacity) {
+        size_t capacity = state->corpus_capacity ? state->corpus_capacity * 2 : 64;
+        input_t* grown = realloc(state->corpus, capacity * sizeof(input_t));
+        if (!grown)
+            return;
+        state->corpus = grown;
+        state->corpus_capacity = capacity;
+    }
+    uint8_t* copy = malloc(size ? size : 1);
+    if (!copy)
+        return;
+    memcpy(copy, data, size);
+    state->corpus[state->corpus_count++] = (input_t){ copy, size };
+}
+
+// Merges a run's coverage. Returns true if it hit a pair of opcode kinds never seen before.
+static bool coverage_merge(fuzz_state_t* state, const uint8_t* coverage) {
+    bool novel = false;
+    for (int i = 0; i < COVERAGE_BITS; i++) {
+        if (coverage[i] && !state->coverage[i]) {
+            state->coverage[i] = 1;
+            state->features++;
+            novel = true;
+        }
+    }
+    return novel;
+}
+
+/*
+    A random program of plausible instructions: jump and call targets land on
+    instructions of the program, 8xyN/ExNN/FxNN use valid low bytes most of
+    the time, and Annn points anywhere so loads and stores hit code, font
+    and free memory alike.
+*/
+static size_t generate_input(uint64_t* rng, uint8_t* out) {
+    static const uint8_t fx_ops[] = { 0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x33, 0x55, 0x65 };
+    static const uint8_t alu_ops[] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE };
+    for (int i = 0; i < FUZZ_HEADER_SIZE; i++)
+        out[i] = (uint8_t)next_random(rng);
+    out[23] &= 0x3F; // clock rates from 60 to about 2400 Hz
+
+    size_t instructions = 2 + next_random(rng) % 256;
+    uint8_t* rom = out + FUZZ_HEADER_SIZE;
+    for (size_t n = 0; n < instructions; n++) {
+        uint64_t r = next_random(rng);
+        uint16_t target = 0x200 + 2 * (uint16_t)((r >> 16) % instructions);
+        uint16_t xy = (uint16_t)(r >> 32) & 0x0FF0;
+        uint16_t opcode;
+        switch ((r >> 8) & 0x0F) {
+            case 0x0: opcode = (r & 0x30) ? 0x00E0 : ((r & 0x40) ? 0x00EE : (uint16_t)r & 0x0FFF); break;
+            case 0x1: opcode = 0x1000 | target; break;
+            case 0x2: opcode = 0x2000 | target; break;
+            case 0x8: opcode = 0x8000 | xy | ((r & 0x80) ? (r & 0x0F) : alu_ops[(r >> 40) % sizeof(alu_ops)]); break;
+            case 0xB: opcode = 0xB000 | target; break;
+            case 0xE: opcode = 0xE000 | (xy & 0x0F00) | ((r & 0x80) ? (r & 0xFF) : (r & 1) ? 0x9E : 0xA1); break;
+            case 0xF: opcode = 0xF000 | (xy & 0x0F00) | ((r & 0x80) ? (r & 0xFF) : fx_ops[(r >> 40) % sizeof(fx_ops)]); break;
+            default: opcode = (uint16_t)(((r >> 8) & 0x0F) << 12) | ((uint16_t)(r >> 48) & 0x0FFF); break;
+        }
+        rom[2 * n] = opcode >> 8;
+        rom[2 * n + 1] = opcode & 0xFF;
+    }
+    return FUZZ_HEADER_SIZE + 2 * instructions;
+}
+
+// Byte flips, random instructions and header changes on a corpus entry
+static size_t mutate_input(uint64_t* rng, const input_t* parent, uint8_t* out) {
+    size_t size = parent->size < FUZZ_MAX_INPUT ? parent->size : FUZZ_MAX_INPUT;
+    memcpy(out, parent->data, size);
+    if (size < FUZZ_HEADER_SIZE + 2) {
+        memset(out + size, 0, FUZZ_HEADER_SIZE + 2 - size);
+        size = FUZZ_HEADER_SIZE + 2;
+    }
+    int edits = 1 + next_random(rng) % 8;
+    for (int e = 0; e < edits; e++) {
+        uint64_t r = next_random(rng);
+        size_t at = (r >> 16) % size;
+        switch (r & 3) {
+            case 0: out[at] ^= 1 << ((r >> 8) & 7); break;
+            case 1: out[at] = (uint8_t)(r >> 40); break;
+            case 2: out[(r >> 16) % FUZZ_HEADER_SIZE] = (uint8_t)(r >> 40); break;
+            case 3:
+                if (size + 2 <= FUZZ_MAX_INPUT) {
+                    out[size] = (uint8_t)(r >> 40);
+                    out[size + 1] = (uint8_t)(r >> 48);
+                    size += 2;
+                }
+                break;
+        }
+    }
+    return size;
+}
+
+// Reports a divergent input: keeps it in the corpus directory and prints where it went wrong
+static void report_failure(fuzz_state_t* state, machines_t* m, const core_t* core, const uint8_t* data, size_t size) {
+    pthread_mutex_lock(&state->lock);
+    bool first = !state->diverged;
+    state->diverged = true;
+    state->stop = true;
+    pthread_mutex_unlock(&state->lock);
+    if (!first)
+        return;
+    char path[4096];
+    write_input(state->corpus_dir, "diverge-", data, size, path, sizeof(path));
+    report_divergence(stdout, m, core, data, size, state->cycles);
+    printf("  input saved as %s\n", path);
+}
+
+static void* fuzz_worker_main(void* arg) {
+    fuzz_worker_t* worker = arg;
+    fuzz_state_t* state = worker->state;
+    machines_t m;
+    uint8_t* input = malloc(FUZZ_MAX_INPUT);
+    uint8_t* coverage = malloc(COVERAGE_BITS);
+    if (!machines_alloc(&m) || !input || !coverage) {
+        printf("Error: Out of memory in fuzz worker\n");
+        machines_free(&m);
+        free(input);
+        free(coverage);
+        return NULL;
+    }
+
+    for (;;) {
+        size_t size;
+        pthread_mutex_lock(&state->lock);
+        bool done = state->stop || (state->max_runs && state->runs >= state->max_runs) || now_ns() >= state->deadline_ns;
+        state->runs++;
+        if (!done && state->corpus_count > 0 && next_random(&worker->rng) % 2)
+            size = mutate_input(&worker->rng, &state->corpus[next_random(&worker->rng) % state->corpus_count], input);
+        else
+            size = done ? 0 : generate_input(&worker->rng, input);
+        pthread_mutex_unlock(&state->lock);
+        if (done)
+            break;
+
+        memset(coverage, 0, COVERAGE_BITS);
+        const core_t* core = check_input(&m, input, size, state->cycles, coverage);
+        if (core) {
+            report_failure(state, &m, core, input, size);
+            break;
+        }
+
+        pthread_mutex_lock(&state->lock);
+        if (coverage_merge(state, coverage)) {
+            char path[4096];
+            corpus_add(state, input, size);
+            write_input(state->corpus_dir, "", input, size, path, sizeof(path));
+        }
+        pthread_mutex_unlock(&state->lock);
+    }
+
+    machines_free(&m);
+    free(input);
+    free(coverage);
+    return NULL;
+}
+
+// Replays every file already in the corpus directory. Returns false if one diverges.
+static bool replay_corpus(fuzz_state_t* state) {
+    DIR* dir = opendir(state->corpus_dir);
+    if (!dir)
+        return true;
+    machines_t m;
+    uint8_t* input = malloc(FUZZ_MAX_INPUT);
+    uint8_t* coverage = malloc(COVERAGE_BITS);
+    if (!machines_alloc(&m) || !input || !coverage) {
+        printf("Error: Out of memory replaying the corpus\n");
+        closedir(dir);
+        machines_free(&m);
+        free(input);
+        free(coverage);
+        return false;
+    }
+
+    bool ok = true;
+    size_t replayed = 0;
+    struct dirent* entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", state->corpus_dir, entry->d_name);
+        FILE* file = fopen(path, "rb");
+        if (!file)
+            continue;
+        size_t size = fread(input, 1, FUZZ_MAX_INPUT, file);
+        fclose(file);
+
+        memset(coverage, 0, COVERAGE_BITS);
+        const core_t* core = check_input(&m, input, size, state->cycles, coverage);
+        if (core) {
+            printf("Corpus input %s:\n", path);
+            report_divergence(stdout, &m, core, input, size, state->cycles);
+            state->diverged = true;
+            ok = false;
+        }
+        coverage_merge(state, coverage);
+        corpus_add(state, input, size);
+        replayed++;
+    }
+    closedir(dir);
+    printf("Replayed %zu corpus inputs from %s\n", replayed, state->corpus_dir);
+    machines_free(&m);
+    free(input);
+    free(coverage);
+    return ok;
+}
+
+static void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [options] [corpus_dir]\n", prog_name);
+    fprintf(stderr, "\nCompares the '" DISPATCH_NAME "' and 'lanes' cores against the reference interpreter.\n");
+    fprintf(stderr, "\nOptions:\n");
+    fprintf(stderr, "  -h, --help            Show this help message and exit\n");
+    fprintf(stderr, "  -j, --jobs <n>        Fuzzing workers (default: one per online CPU)\n");
+    fprintf(stderr, "  -t, --time <seconds>  Stop after this long (default: 10)\n");
+    fprintf(stderr, "  -n, --runs <n>        Stop after this many inputs (default: no limit)\n");
+    fprintf(stderr, "  -c, --cycles <n>      Instructions per input (default: 20000)\n");
+    fprintf(stderr, "  -s, --seed <n>        Generator seed (default: time-based)\n");
+    fprintf(stderr, "corpus_dir defaults to tests/corpus. Inputs that reach new pairs of opcode kinds are\n");
+    fprintf(stderr, "saved there, and divergent ones as diverge-<hash>; all of it is replayed on the next run.\n");
+}
+
+int main(int argc, char *argv[]) {
+    long worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seconds = 10, seed = (uint64_t)time(NULL);
+    static fuzz_state_t state;
+    state.cycles = 20000;
+    state.corpus_dir = "tests/corpus";
+
+    static struct option long_options[] = {
+        {"help",   no_argument,       0, 'h'},
+        {"jobs",   required_argument, 0, 'j'},
+        {"time",   required_argument, 0, 't'},
+        {"runs",   required_argument, 0, 'n'},
+        {"cycles", required_argument, 0, 'c'},
+        {"seed",   required_argument, 0, 's'},
+        {0, 0, 0, 0}
+    };
+    int opt_char;
+    while ((opt_char = getopt_long(argc, argv, "hj:t:n:c:s:", long_options, NULL)) != -1) {
+        char* endptr = NULL;
+        unsigned long long value = optarg ? strtoull(optarg, &endptr, 0) : 0;
+        if (optarg && (*optarg == '\0' || *optarg == '-' || *endptr != '\0')) {
+            fprintf(stderr, "Error: Invalid number for -%c: '%s'\n", opt_char, optarg);
+            return 1;
+        }
+        switch (opt_char) {
+            case 'h': print_usage(argv[0]); return 0;
+            case 'j': worker_count = (long)value; break;
+            case 't': seconds = value; break;
+            case 'n': state.max_runs = value; break;
+            case 'c': state.cycles = value; break;
+            case 's': seed = value; break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (optind < argc)
+        state.corpus_dir = argv[optind];
+    if (worker_count < 1)
+        worker_count = 1;
+    if (state.cycles == 0) {
+        fprintf(stderr, "Error: --cycles must be positive\n");
+        return 1;
+    }
+    mkdir(state.corpus_dir, 0755);
+    // The core reports the first unknown opcode of every run on stderr, and most random programs hit one
+    if (!freopen("/dev/null", "w", stderr)) {
+        fprintf(stderr, "Error: Could not silence stderr\n");
+        return 1;
+    }
+    pthread_mutex_init(&state.lock, NULL);
+
+    if (!replay_corpus(&state))
+        return 1;
+
+    printf("Fuzzing cores '" DISPATCH_NAME "' and 'lanes' with %ld workers, %" PRIu64 " cycles per input, seed %" PRIu64 "\n",
+           worker_count, state.cycles, seed);
+    uint64_t start = now_ns();
+    state.deadline_ns = start + seconds * 1000000000ull;
+    fuzz_worker_t* workers = calloc(worker_count, sizeof(fuzz_worker_t));
+    pthread_t* threads = calloc(worker_count, sizeof(pthread_t));
+    if (!workers || !threads) {
+        printf("Error: Out of memory\n");
+        return 1;
+    }
+    int started = 0;
+    for (int w = 0; w < worker_count; w++) {
+        workers[w].state = &state;
+        workers[w].rng = (seed + w) * 0x9E3779B97F4A7C15ull | 1;
+        if (pthread_create(&threads[w], NULL, fuzz_worker_main, &workers[w]) != 0) {
+            printf("Error: Could not start worker %d\n", w);
+            break;
+        }
+        started++;
+    }
+    if (started == 0)
+        fuzz_worker_main(&workers[0]);
+    for (int w = 0; w < started; w++)
+        pthread_join(threads[w], NULL);
+
+    double elapsed = (now_ns() - start) / 1e9;
+    printf("%" PRIu64 " inputs in %.1f s (%.0f/s), %u opcode pairs covered, corpus %zu inputs: %s\n",
+           state.runs, elapsed, elapsed > 0 ? state.runs / elapsed : 0.0, state.features, state.corpus_count,
+           state.diverged ? "DIVERGED" : "no divergence");
+
+    for (size_t i = 0; i < state.corpus_count; i++)
+        free(state.corpus[i].data);
+    free(state.corpus);
+    free(workers);
+    free(threads);
+    return state.diverged ? 1 : 0;
+}
+
+#endif // CHIP8_FUZZ_LIBFUZZER
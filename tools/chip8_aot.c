@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    chip8-aot: static recompiler from a CHIP-8 ROM to a C translation unit.
+
+    Starting at 0x200 it follows every statically known control-flow edge
+    (fall-through, both sides of skips, 1nnn/2nnn targets and 2nnn return
+    points) and emits one C function per basic block. Bnnn targets are
+    computed at run time, so they end the walk; if execution reaches an
+    untranslated address the core falls back to the interpreter.
+*/
+
+#define MEMORY_SIZE 4096
+#define ROM_START 0x200
+#define MAX_BLOCK_INSTRUCTIONS 64
+
+typedef enum {
+    INSN_INLINE,     // translated to plain C
+    INSN_HELPER,     // calls an op_* handler, execution continues in the block
+    INSN_TERMINATOR  // may change the PC or store to memory, ends the block
+} insn_class_t;
+
+static uint8_t memory[MEMORY_SIZE];
+static uint32_t rom_end;
+static bool is_block_start[MEMORY_SIZE];
+static uint16_t block_bytes[MEMORY_SIZE];
+static bool is_code[MEMORY_SIZE];
+
+static uint16_t worklist[MEMORY_SIZE];
+static int worklist_size;
+
+static void push_block(uint32_t address) {
+    if (address < ROM_START || address + 1 >= rom_end || is_block_start[address])
+        return;
+    is_block_start[address] = true;
+    worklist[worklist_size++] = (uint16_t)address;
+}
+
+static uint16_t fetch(uint32_t address) {
+    return (memory[address] << 8) | memory[address + 1];
+}
+
+// Name of the op_* handler the reference core would run (NULL if translated inline)
+static const char* handler_name(uint16_t opcode) {
+    uint8_t kk = opcode & 0xFF;
+    switch (opcode >> 12) {
+        case 0x0:
+            if (opcode == 0x00E0) return "op_00E0";
+            if (opcode == 0x00EE) return "op_00EE";
+            return "op_unknown";
+        case 0x2: return "op_2nnn";
+        case 0xB: return "op_Bnnn";
+        case 0xC: return "op_Cxkk";
+        case 0xD: return "op_Dxyn";
+        case 0xE:
+            if (kk == 0x9E) return "op_Ex9E";
+            if (kk == 0xA1) return "op_ExA1";
+            return "op_unknown";
+        case 0x8:
+            switch (opcode & 0x0F) {
+                case 0x0: case 0x1: case 0x2: case 0x3: case 0x4:
+                case 0x5: case 0x6: case 0x7: case 0xE:
+                    return NULL;
+                default:
+                    return "op_unknown";
+            }
+        case 0xF:
+            switch (kk) {
+                case 0x07: case 0x15: case 0x18: case 0x1E: case 0x29:
+                    return NULL;
+                case 0x0A: return "op_Fx0A";
+                case 0x33: return "op_Fx33";
+                case 0x55: case 0x65:
+                    return "chip8_resolve_handler"; // legacy variant depends on the instance's quirks
+                default: return "op_unknown";
+            }
+        default:
+            return NULL;
+    }
+}
+
+static insn_class_t classify(uint16_t opcode) {
+    switch (opcode >> 12) {
+        case 0x1: case 0x2: case 0x3: case 0x4: case 0x5: case 0x9: case 0xB: case 0xE:
+            return INSN_TERMINATOR;
+        case 0x0:
+            return (opcode == 0x00E0) ? INSN_HELPER : INSN_TERMINATOR;
+        case 0xC: case 0xD:
+            return INSN_HELPER;
+        case 0x8:
+            return handler_name(opcode) ? INSN_TERMINATOR : INSN_INLINE;
+        case 0xF:
+            switch (opcode & 0xFF) {
+                case 0x65: return INSN_HELPER;
+                case 0x0A: case 0x33: case 0x55: return INSN_TERMINATOR;
+                default: return handler_name(opcode) ? INSN_TERMINATOR : INSN_INLINE;
+            }
+        default:
+            return INSN_INLINE;
+    }
+}
+
+// Walks one block and queues its successors
+static void discover_block(uint16_t start) {
+    uint32_t address = start;
+    for (int n = 0; n < MAX_BLOCK_INSTRUCTIONS && address + 1 < rom_end; n++) {
+        uint16_t opcode = fetch(address);
+        is_code[address] = is_code[address + 1] = true;
+        block_bytes[start] += 2;
+
+        if (classify(opcode) == INSN_TERMINATOR) {
+            uint16_t nnn = opcode & 0x0FFF;
+            switch (opcode >> 12) {
+                case 0x1: push_block(nnn); break;
+                case 0x2: push_block(nnn); push_block(address + 2); break;
+                case 0x3: case 0x4: case 0x5: case 0x9: case 0xE:
+                    push_block(address + 2); push_block(address + 4); break;
+                case 0x0: if (opcode == 0x00EE) break; push_block(address + 2); break;
+                case 0xB: break;
+                default: push_block(address + 2); break;
+            }
+            return;
+        }
+        address += 2;
+    }
+    push_block(address);
+}
+
+static void emit_handler_call(FILE* out, uint16_t opcode) {
+    const char* name = handler_name(opcode);
+    if (strcmp(name, "chip8_resolve_handler") == 0)
+        fprintf(out, "chip8_resolve_handler(chip8, 0x%04X)(chip8, 0x%04X)", opcode, opcode);
+    else
+        fprintf(out, "%s(chip8, 0x%04X)", name, opcode);
+}
+
+static void emit_inline(FILE* out, uint16_t opcode) {
+    unsigned x = (opcode >> 8) & 0x0F;
+    unsigned y = (opcode >> 4) & 0x0F;
+    unsigned kk = opcode & 0xFF;
+    unsigned nnn = opcode & 0x0FFF;
+
+    switch (opcode >> 12) {
+        case 0x6: fprintf(out, "V[0x%X] = 0x%02X;", x, kk); break;
+        case 0x7: fprintf(out, "V[0x%X] += 0x%02X;", x, kk); break;
+        case 0xA: fprintf(out, "chip8->I = 0x%03X;", nnn); break;
+        case 0x8:
+            switch (opcode & 0x0F) {
+                case 0x0: fprintf(out, "V[0x%X] = V[0x%X];", x, y); break;
+                case 0x1: fprintf(out, "V[0x%X] |= V[0x%X];", x, y); break;
+                case 0x2: fprintf(out, "V[0x%X] &= V[0x%X];", x, y); break;
+                case 0x3: fprintf(out, "V[0x%X] ^= V[0x%X];", x, y); break;
+                case 0x4:
+                    fprintf(out, "{ uint16_t sum = V[0x%X] + V[0x%X]; V[0xF] = (sum > 255) ? 1 : 0; V[0x%X] = (uint8_t)sum; }",
+                            x, y, x);
+                    break;
+                case 0x5: fprintf(out, "V[0xF] = (V[0x%X] > V[0x%X]) ? 1 : 0; V[0x%X] -= V[0x%X];", x, y, x, y); break;
+                case 0x6: fprintf(out, "V[0xF] = V[0x%X] & 1; V[0x%X] >>= 1;", x, x); break;
+                case 0x7: fprintf(out, "V[0xF] = (V[0x%X] > V[0x%X]) ? 1 : 0; V[0x%X] = V[0x%X] - V[0x%X];", y, x, x, y, x); break;
+                case 0xE: fprintf(out, "V[0xF] = (V[0x%X] & 0x80) >> 7; V[0x%X] <<= 1;", x, x); break;
+            }
+            break;
+        case 0xF:
+            switch (kk) {
+                case 0x07: fprintf(out, "V[0x%X] = chip8->delay_timer;", x); break;
+                case 0x15: fprintf(out, "chip8->delay_timer = V[0x%X];", x); break;
+                case 0x18: fprintf(out, "chip8->sound_timer = V[0x%X];", x); break;
+                case 0x1E: fprintf(out, "chip8->I += V[0x%X];", x); break;
+                case 0x29: fprintf(out, "chip8->I = FONT_START_ADDRESS + (V[0x%X] * 5);", x); break;
+            }
+            break;
+    }
+}
+
+static void emit_terminator(FILE* out, uint32_t address, uint16_t opcode, unsigned length) {
+    unsigned x = (opcode >> 8) & 0x0F;
+    unsigned y = (opcode >> 4) & 0x0F;
+    unsigned kk = opcode & 0xFF;
+    unsigned nnn = opcode & 0x0FFF;
+    const char* condition = NULL;
+    char buffer[64];
+
+    switch (opcode >> 12) {
+        case 0x1:
+            fprintf(out, "    chip8->pc = 0x%03X;\n", nnn);
+            break;
+        case 0x3: snprintf(buffer, sizeof(buffer), "V[0x%X] == 0x%02X", x, kk); condition = buffer; break;
+        case 0x4: snprintf(buffer, sizeof(buffer), "V[0x%X] != 0x%02X", x, kk); condition = buffer; break;
+        case 0x5: snprintf(buffer, sizeof(buffer), "V[0x%X] == V[0x%X]", x, y); condition = buffer; break;
+        case 0x9: snprintf(buffer, sizeof(buffer), "V[0x%X] != V[0x%X]", x, y); condition = buffer; break;
+        default:
+            fprintf(out, "    chip8->pc = 0x%03X;\n", address);
+            fprintf(out, "    if (!");
+            emit_handler_call(out, opcode);
+            fprintf(out, ")\n        chip8->pc += 2;\n");
+            break;
+    }
+    if (condition)
+        fprintf(out, "    chip8->pc = (%s) ? 0x%03X : 0x%03X;\n", condition, address + 4, address + 2);
+    fprintf(out, "    return %u;\n", length);
+}
+
+static void emit_block(FILE* out, uint16_t start) {
+    fprintf(out, "static uint32_t block_%03X(chip8_t* chip8) {\n", start);
+    fprintf(out, "    uint8_t* const V = chip8->V;\n");
+    fprintf(out, "    (void)V;\n");
+
+    unsigned length = block_bytes[start] / 2;
+    uint32_t address = start;
+    for (unsigned n = 1; n <= length; n++, address += 2) {
+        uint16_t opcode = fetch(address);
+        switch (classify(opcode)) {
+            case INSN_INLINE:
+                fprintf(out, "    ");
+                emit_inline(out, opcode);
+                fprintf(out, " // 0x%03X: %04X\n", address, opcode);
+                break;
+            case INSN_HELPER:
+                fprintf(out, "    ");
+                emit_handler_call(out, opcode);
+                fprintf(out, "; // 0x%03X\n", address);
+                break;
+            case INSN_TERMINATOR:
+                fprintf(out, "    // 0x%03X: %04X\n", address, opcode);
+                emit_terminator(out, address, opcode, length);
+                fprintf(out, "}\n\n");
+                return;
+        }
+    }
+    fprintf(out, "    chip8->pc = 0x%03X;\n", address);
+    fprintf(out, "    return %u;\n}\n\n", length);
+}
+
+static void emit_byte_array(FILE* out, const char* decl, const uint8_t* bytes, uint32_t count) {
+    fprintf(out, "%s = {", decl);
+    for (uint32_t i = 0; i < count; i++)
+        fprintf(out, "%s0x%02X,", (i % 16 == 0) ? "\n    " : " ", bytes[i]);
+    fprintf(out, "\n};\n\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <rom_path> <output.c>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* rom_file = fopen(argv[1], "rb");
+    if (!rom_file) {
+        fprintf(stderr, "Error: Could not open ROM file %s\n", argv[1]);
+        return 1;
+    }
+    size_t rom_size = fread(&memory[ROM_START], 1, MEMORY_SIZE - ROM_START, rom_file);
+    fclose(rom_file);
+    rom_end = ROM_START + (uint32_t)rom_size;
+
+    push_block(ROM_START);
+    while (worklist_size > 0)
+        discover_block(worklist[--worklist_size]);
+
+    FILE* out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "Error: Could not open output file %s\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "/* Generated by chip8-aot from %s. Do not edit. */\n", argv[1]);
+    fprintf(out, "#include <string.h>\n#include \"chip8.h\"\n#include \"opcodes.h\"\n#include \"aot.h\"\n\n");
+    fprintf(out, "#define AOT_ROM_SIZE %zu\n\n", rom_size);
+    emit_byte_array(out, "static const uint8_t aot_rom[AOT_ROM_SIZE]", &memory[ROM_START], (uint32_t)rom_size);
+    uint8_t code_map[MEMORY_SIZE];
+    for (uint32_t a = 0; a < rom_size; a++)
+        code_map[a] = is_code[ROM_START + a];
+    emit_byte_array(out, "static const uint8_t aot_code_map[AOT_ROM_SIZE]", code_map, (uint32_t)rom_size);
+
+    int blocks = 0;
+    for (uint32_t a = ROM_START; a < rom_end; a++) {
+        if (is_block_start[a]) {
+            emit_block(out, (uint16_t)a);
+            blocks++;
+        }
+    }
+
+    fprintf(out, "typedef uint32_t (*aot_block_func_t)(chip8_t* chip8);\n\n");
+    fprintf(out, "static const aot_block_func_t aot_blocks[MEMORY_SIZE] = {\n");
+    for (uint32_t a = ROM_START; a < rom_end; a++)
+        if (is_block_start[a])
+            fprintf(out, "    [0x%03X] = block_%03X,\n", a, a);
+    fprintf(out, "};\n\n");
+    fprintf(out, "static const uint16_t aot_block_bytes[MEMORY_SIZE] = {\n");
+    for (uint32_t a = ROM_START; a < rom_end; a++)
+        if (is_block_start[a])
+            fprintf(out, "    [0x%03X] = %u,\n", a, block_bytes[a]);
+    fprintf(out, "};\n\n");
+
+    fprintf(out,
+        "uint32_t chip8_aot_run_block(chip8_t* chip8, uint32_t budget) {\n"
+        "    uint16_t pc = chip8->pc;\n"
+        "    if (pc >= MEMORY_SIZE || !aot_blocks[pc] || aot_block_bytes[pc] / 2u > budget)\n"
+        "        return 0;\n"
+        "    if (chip8->aot_code_modified\n"
+        "        && memcmp(&chip8->memory[pc], &aot_rom[pc - 0x200], aot_block_bytes[pc]) != 0)\n"
+        "        return 0;\n"
+        "    return aot_blocks[pc](chip8);\n"
+        "}\n\n"
+        "void chip8_aot_check_write(chip8_t* chip8, uint16_t address, uint16_t length) {\n"
+        "    for (uint32_t a = address; a < (uint32_t)address + length; a++) {\n"
+        "        if (a < 0x200 || a >= 0x200 + AOT_ROM_SIZE)\n"
+        "            continue;\n"
+        "        if (aot_code_map[a - 0x200] && chip8->memory[a] != aot_rom[a - 0x200])\n"
+        "            chip8->aot_code_modified = true;\n"
+        "    }\n"
+        "}\n");
+
+    fclose(out);
+    printf("Translated %d blocks from %s into %s\n", blocks, argv[1], argv[2]);
+    return 0;
+}
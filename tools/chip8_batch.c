@@ -0,0 +1,581 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "chip8.h"
+#include "lanes.h"
+#include "snapshot.h"
+
+/*
+    chip8-batch: runs many headless jobs across all cores and prints one
+    result line per job, in manifest order.
+
+    Manifest: one job per line, '#' starts a comment. The ROM path comes
+    first, followed by optional key=value fields:
+        cycles=N      instructions to execute (default 1000000)
+        seed=N        Cxkk PRNG seed (default 0)
+        clock=HZ      clock rate, sets how many cycles pass per timer tick (default 500)
+        quirks=Q      "legacy" or "none" (default none)
+        input=EVENTS  comma-separated <cycle>:<key><+|-> in cycle order, key is
+                      a hex digit and + presses, - releases, e.g. 1000:5+,1200:5-
+        state=FILE    start from this save state instead of power-on
+        save=FILE     write the final state to FILE
+    cycles counts from power-on, so with state= it includes the cycles
+    already in the save state.
+    Example:
+        roms/PONG cycles=500000 seed=7 input=600:1+,900:1-
+
+    Jobs are spread over per-worker deques. A worker pops from the back of
+    its own deque and, once that is empty, steals from the front of another
+    worker's, so long jobs never leave the other cores idle.
+
+    With --lanes, consecutive jobs that share a ROM, cycle count and clock
+    rate and have no input events are packed into groups of up to
+    CHIP8_LANES and run as one lockstep multi-lane unit (see lanes.h).
+    Results are the same as without it; each job in a group reports the
+    group's wall time.
+*/
+
+#define DEFAULT_JOB_CYCLES 1000000
+#define MAX_LINE 4096
+
+typedef struct {
+    uint64_t cycle;
+    uint8_t key;
+    bool down;
+} input_event_t;
+
+typedef struct {
+    // From the manifest
+    char* rom_path;
+    uint64_t cycles;
+    uint64_t seed;
+    uint32_t clock_rate;
+    bool legacy;
+    input_event_t* events;
+    size_t event_count;
+    char* load_state;
+    char* save_state;
+    int line;
+    // Results
+    bool ok;
+    uint64_t cycles_run;
+    uint64_t display_hash;
+    uint16_t pc;
+    uint16_t I;
+    uint8_t V[NUM_REGISTERS];
+    uint64_t unknown_opcodes;
+    uint64_t wall_ns;
+} job_t;
+
+// A contiguous run of jobs, executed together when count > 1
+typedef struct {
+    size_t first;
+    size_t count;
+} work_unit_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    work_unit_t* items;
+    size_t head;   // thieves take from here
+    size_t tail;   // the owner pushes and pops here
+} work_deque_t;
+
+typedef struct {
+    job_t* jobs;
+    work_deque_t* deques;
+    int worker_count;
+} batch_t;
+
+typedef struct {
+    batch_t* batch;
+    int id;
+    uint64_t steals;
+} worker_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [options] <manifest>\n", prog_name);
+    fprintf(stderr, "\nOptions:\n");
+    fprintf(stderr, "  -h, --help            Show this help message and exit\n");
+    fprintf(stderr, "  -j, --jobs <n>        Worker threads (default: one per online CPU)\n");
+    fprintf(stderr, "  -l, --lanes           Run compatible consecutive jobs as lockstep lanes\n");
+    fprintf(stderr, "  -o, --output <file>   Write results to <file> instead of stdout\n");
+}
+
+// --- Manifest parsing ---
+
+static int parse_u64(const char* str, uint64_t* val) {
+    char* endptr;
+    if (*str == '\0' || *str == '-')
+        return -1;
+    *val = strtoull(str, &endptr, 0);
+    return (*endptr == '\0') ? 0 : -1;
+}
+
+// Releases what parse_job allocated; the job can be parsed into again afterwards
+static void free_job(job_t* job) {
+    free(job->rom_path);
+    free(job->events);
+    free(job->load_state);
+    free(job->save_state);
+    job->rom_path = NULL;
+    job->events = NULL;
+    job->event_count = 0;
+    job->load_state = NULL;
+    job->save_state = NULL;
+}
+
+// Events must be listed in cycle order; events at the same cycle apply in the order given.
+// A repeated input= replaces the earlier one.
+static int parse_input(const char* spec, job_t* job) {
+    free(job->events);
+    job->event_count = 0;
+    size_t capacity = 1;
+    for (const char* p = spec; *p; p++)
+        capacity += (*p == ',');
+    job->events = calloc(capacity, sizeof(input_event_t));
+    char* copy = strdup(spec);
+    if (!job->events || !copy) {
+        free(copy);
+        return -1;
+    }
+
+    int result = 0;
+    char* saveptr;
+    for (char* item = strtok_r(copy, ",", &saveptr); item; item = strtok_r(NULL, ",", &saveptr)) {
+        char* colon = strchr(item, ':');
+        size_t len = strlen(item);
+        if (!colon || len < 4 || colon[1] == '\0' || colon[2] == '\0' || colon[3] != '\0'
+            || (colon[2] != '+' && colon[2] != '-')) {
+            result = -1;
+            break;
+        }
+        // <cycle>:<key as a hex digit, like the keypad labels><+ for press, - for release>
+        char* endptr;
+        char key_digit[2] = { colon[1], '\0' };
+        unsigned long key = strtoul(key_digit, &endptr, 16);
+        input_event_t* event = &job->events[job->event_count];
+        *colon = '\0';
+        if (*endptr != '\0' || parse_u64(item, &event->cycle) != 0
+            || (job->event_count > 0 && event->cycle < event[-1].cycle)) {
+            result = -1;
+            break;
+        }
+        event->key = (uint8_t)key;
+        event->down = colon[2] == '+';
+        job->event_count++;
+    }
+    free(copy);
+    return result;
+}
+
+static int parse_job(char* line, int line_number, job_t* job) {
+    memset(job, 0, sizeof(*job));
+    job->cycles = DEFAULT_JOB_CYCLES;
+    job->clock_rate = DEFAULT_CLOCK_RATE;
+    job->line = line_number;
+
+    char* saveptr;
+    char* token = strtok_r(line, " \t\r\n", &saveptr);
+    job->rom_path = strdup(token);
+
+    while ((token = strtok_r(NULL, " \t\r\n", &saveptr)) != NULL) {
+        char* value = strchr(token, '=');
+        if (!value) {
+            fprintf(stderr, "Error: manifest line %d: expected key=value, got '%s'\n", line_number, token);
+            free_job(job);
+            return -1;
+        }
+        *value++ = '\0';
+        uint64_t number;
+        if (strcmp(token, "cycles") == 0 && parse_u64(value, &number) == 0) {
+            job->cycles = number;
+        } else if (strcmp(token, "seed") == 0 && parse_u64(value, &number) == 0) {
+            job->seed = number;
+        } else if (strcmp(token, "clock") == 0 && parse_u64(value, &number) == 0 && number > 0 && number <= UINT32_MAX) {
+            job->clock_rate = (uint32_t)number;
+        } else if (strcmp(token, "quirks") == 0 && (strcmp(value, "legacy") == 0 || strcmp(value, "none") == 0)) {
+            job->legacy = strcmp(value, "legacy") == 0;
+        } else if (strcmp(token, "input") == 0 && parse_input(value, job) == 0) {
+            // parsed
+        } else if (strcmp(token, "state") == 0 && *value) {
+            free(job->load_state);
+            job->load_state = strdup(value);
+        } else if (strcmp(token, "save") == 0 && *value) {
+            free(job->save_state);
+            job->save_state = strdup(value);
+        } else {
+            fprintf(stderr, "Error: manifest line %d: invalid %s=%s\n", line_number, token, value);
+            free_job(job);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static job_t* load_manifest(const char* path, size_t* count) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open manifest %s\n", path);
+        return NULL;
+    }
+
+    job_t* jobs = NULL;
+    size_t capacity = 0;
+    *count = 0;
+    char line[MAX_LINE];
+    int line_number = 0;
+    bool failed = false;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+        if (strspn(line, " \t\r\n") == strlen(line))
+            continue;
+
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            job_t* grown = realloc(jobs, capacity * sizeof(job_t));
+            if (!grown) {
+                fprintf(stderr, "Error: Out of memory reading the manifest\n");
+                failed = true;
+                break;
+            }
+            jobs = grown;
+        }
+        if (parse_job(line, line_number, &jobs[*count]) != 0) {
+            failed = true;
+            break;
+        }
+        (*count)++;
+    }
+
+    if (file != stdin)
+        fclose(file);
+    if (!failed && *count == 0) {
+        fprintf(stderr, "Error: Manifest %s has no jobs\n", path);
+        failed = true;
+    }
+    if (failed) {
+        // A line that failed to parse has already released its own job
+        for (size_t i = 0; i < *count; i++)
+            free_job(&jobs[i]);
+        free(jobs);
+        return NULL;
+    }
+    return jobs;
+}
+
+// --- Running jobs ---
+
+// Reads the ROM and returns an initialised machine with it loaded, or NULL
+static chip8_t* job_setup(const job_t* job) {
+    FILE* rom_file = fopen(job->rom_path, "rb");
+    if (!rom_file) {
+        fprintf(stderr, "Error: Could not open ROM file %s\n", job->rom_path);
+        return NULL;
+    }
+    uint8_t program[MEMORY_SIZE];
+    size_t size = fread(program, 1, sizeof(program), rom_file);
+    fclose(rom_file);
+
+    chip8_config config = {0};
+    config.clock_rate = job->clock_rate;
+    config.legacy_mode = job->legacy;
+    config.seed = job->seed;
+    config.trace_level = TRACE_OFF;
+
+    // chip8_t is too large for a worker's stack with the predecoded core
+    chip8_t* chip8 = malloc(sizeof(chip8_t));
+    if (!chip8)
+        return NULL;
+    chip8_initialize(chip8, &config);
+    if (chip8_load_program(chip8, program, size) != 0
+        || (job->load_state && chip8_load_state(chip8, job->load_state) != 0)) {
+        chip8_shutdown(chip8);
+        free(chip8);
+        return NULL;
+    }
+    return chip8;
+}
+
+// Records the machine's final state in the job, saves it if asked and frees it
+static void job_finish(job_t* job, chip8_t* chip8) {
+    job->ok = !job->save_state || chip8_save_state(chip8, job->save_state) == 0;
+    job->cycles_run = chip8->cycles;
+    job->display_hash = chip8_display_hash(chip8->display);
+    job->pc = chip8->pc;
+    job->I = chip8->I;
+    memcpy(job->V, chip8->V, sizeof(job->V));
+    job->unknown_opcodes = chip8->unknown_opcodes;
+    chip8_shutdown(chip8);
+    free(chip8);
+}
+
+static void run_job(job_t* job) {
+    uint64_t start = now_ns();
+    chip8_t* chip8 = job_setup(job);
+    if (chip8) {
+        // Same scheduling as the emulator: stop at every timer tick and input event
+        size_t next_event = 0;
+        while (chip8->cycles < job->cycles) {
+            while (next_event < job->event_count && job->events[next_event].cycle <= chip8->cycles) {
+                chip8->keypad[job->events[next_event].key] = job->events[next_event].down;
+                next_event++;
+            }
+            uint64_t run = chip8_cycles_until_tick(chip8);
+            if (job->cycles - chip8->cycles < run)
+                run = job->cycles - chip8->cycles;
+            if (next_event < job->event_count && job->events[next_event].cycle - chip8->cycles < run)
+                run = job->events[next_event].cycle - chip8->cycles;
+            chip8_run_cycles(chip8, (uint32_t)run);
+            while (chip8_cycles_until_tick(chip8) == 0)
+                update_timers(chip8);
+        }
+        job_finish(job, chip8);
+    }
+    job->wall_ns = now_ns() - start;
+}
+
+// Runs a group packed by pack_lanes; all its jobs share the ROM, cycles and clock rate
+static void run_lanes(job_t* jobs, size_t count) {
+    uint64_t start = now_ns();
+    chip8_t* machines[CHIP8_LANES];
+    job_t* owners[CHIP8_LANES];
+    uint32_t live = 0;
+    for (size_t i = 0; i < count; i++) {
+        chip8_t* chip8 = job_setup(&jobs[i]);
+        if (chip8) {
+            machines[live] = chip8;
+            owners[live++] = &jobs[i];
+        }
+    }
+
+    chip8_lanes_t lanes;
+    if (live > 0 && chip8_lanes_init(&lanes, machines, live) == 0) {
+        if (jobs[0].cycles > lanes.cycles)
+            chip8_lanes_run(&lanes, jobs[0].cycles - lanes.cycles);
+        chip8_lanes_sync(&lanes);
+    }
+    for (uint32_t l = 0; l < live; l++)
+        job_finish(owners[l], machines[l]);
+
+    uint64_t elapsed = now_ns() - start;
+    for (size_t i = 0; i < count; i++)
+        jobs[i].wall_ns = elapsed;
+}
+
+static bool lane_compatible(const job_t* a, const job_t* b) {
+    return a->event_count == 0 && b->event_count == 0
+        && a->cycles == b->cycles && a->clock_rate == b->clock_rate
+        && strcmp(a->rom_path, b->rom_path) == 0
+        && (a->load_state == b->load_state
+            || (a->load_state && b->load_state && strcmp(a->load_state, b->load_state) == 0));
+}
+
+// Splits the manifest into work units, returns how many
+static size_t pack_units(const job_t* jobs, size_t job_count, bool lanes, work_unit_t* units) {
+    size_t unit_count = 0;
+    for (size_t i = 0; i < job_count; ) {
+        size_t count = 1;
+        while (lanes && count < CHIP8_LANES && i + count < job_count
+               && lane_compatible(&jobs[i], &jobs[i + count]))
+            count++;
+        units[unit_count++] = (work_unit_t){ i, count };
+        i += count;
+    }
+    return unit_count;
+}
+
+static bool deque_pop(work_deque_t* deque, work_unit_t* unit) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->tail > deque->head;
+    if (found)
+        *unit = deque->items[--deque->tail];
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool deque_steal(work_deque_t* deque, work_unit_t* unit) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->tail > deque->head;
+    if (found)
+        *unit = deque->items[deque->head++];
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static void* worker_main(void* arg) {
+    worker_t* worker = arg;
+    batch_t* batch = worker->batch;
+    uint32_t victim_seed = (uint32_t)worker->id * 2654435761u + 1;
+
+    for (;;) {
+        work_unit_t unit;
+        if (!deque_pop(&batch->deques[worker->id], &unit)) {
+            // No jobs are ever added, so a full sweep of empty deques means we are done
+            bool stolen = false;
+            victim_seed ^= victim_seed << 13;
+            victim_seed ^= victim_seed >> 17;
+            victim_seed ^= victim_seed << 5;
+            int first = victim_seed % batch->worker_count;
+            for (int i = 0; i < batch->worker_count && !stolen; i++) {
+                int victim = (first + i) % batch->worker_count;
+                if (victim != worker->id)
+                    stolen = deque_steal(&batch->deques[victim], &unit);
+            }
+            if (!stolen)
+                return NULL;
+            worker->steals++;
+        }
+        if (unit.count == 1)
+            run_job(&batch->jobs[unit.first]);
+        else
+            run_lanes(&batch->jobs[unit.first], unit.count);
+    }
+}
+
+static void print_results(FILE* out, const job_t* jobs, size_t count) {
+    fprintf(out, "# job\tline\tstatus\tcycles\tdisplay_hash\tpc\tI\tV0-VF\tunknown\twall_us\trom\n");
+    for (size_t i = 0; i < count; i++) {
+        const job_t* job = &jobs[i];
+        fprintf(out, "%zu\t%d\t%s\t%" PRIu64 "\t%016" PRIx64 "\t%03X\t%03X\t",
+                i, job->line, job->ok ? "ok" : "error", job->cycles_run,
+                job->display_hash, job->pc, job->I);
+        for (int r = 0; r < NUM_REGISTERS; r++)
+            fprintf(out, "%02X", job->V[r]);
+        fprintf(out, "\t%" PRIu64 "\t%" PRIu64 "\t%s\n", job->unknown_opcodes, job->wall_ns / 1000, job->rom_path);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* output_path = NULL;
+    bool lanes = false;
+
+    static struct option long_options[] = {
+        {"help",   no_argument,       0, 'h'},
+        {"jobs",   required_argument, 0, 'j'},
+        {"lanes",  no_argument,       0, 'l'},
+        {"output", required_argument, 0, 'o'},
+        {0, 0, 0, 0}
+    };
+
+    int opt_char;
+    while ((opt_char = getopt_long(argc, argv, "hj:lo:", long_options, NULL)) != -1) {
+        switch (opt_char) {
+            case 'h': print_usage(argv[0]); return 0;
+            case 'j':
+                worker_count = strtol(optarg, NULL, 10);
+                if (worker_count <= 0) {
+                    fprintf(stderr, "Error: Invalid positive integer for --jobs: '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'l': lanes = true; break;
+            case 'o': output_path = optarg; break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Error: Missing required manifest argument.\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (worker_count < 1)
+        worker_count = 1;
+
+    size_t job_count;
+    job_t* jobs = load_manifest(argv[optind], &job_count);
+    if (!jobs)
+        return 1;
+
+    work_unit_t* items = malloc(job_count * sizeof(work_unit_t));
+    if (!items) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    size_t unit_count = pack_units(jobs, job_count, lanes, items);
+    if ((size_t)worker_count > unit_count)
+        worker_count = (long)unit_count;
+
+    // Contiguous slices of the manifest per worker, stealing evens out the rest
+    batch_t batch = { jobs, calloc(worker_count, sizeof(work_deque_t)), (int)worker_count };
+    worker_t* workers = calloc(worker_count, sizeof(worker_t));
+    pthread_t* threads = calloc(worker_count, sizeof(pthread_t));
+    if (!batch.deques || !workers || !threads) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    for (int w = 0; w < batch.worker_count; w++) {
+        work_deque_t* deque = &batch.deques[w];
+        pthread_mutex_init(&deque->lock, NULL);
+        deque->items = items;
+        deque->head = unit_count * w / batch.worker_count;
+        deque->tail = unit_count * (w + 1) / batch.worker_count;
+    }
+
+    uint64_t start = now_ns();
+    int started = 0;
+    for (int w = 0; w < batch.worker_count; w++) {
+        workers[w].batch = &batch;
+        workers[w].id = w;
+    }
+    for (; started < batch.worker_count; started++) {
+        if (pthread_create(&threads[started], NULL, worker_main, &workers[started]) != 0) {
+            // Work on the main thread instead, the deques of workers that never started get stolen
+            fprintf(stderr, "Error: Could not start worker %d\n", started);
+            worker_main(&workers[started]);
+            break;
+        }
+    }
+    uint64_t steals = 0;
+    for (int w = 0; w < batch.worker_count; w++) {
+        if (w < started)
+            pthread_join(threads[w], NULL);
+        steals += workers[w].steals;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    FILE* out = output_path ? fopen(output_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Error: Could not open output file %s\n", output_path);
+        return 1;
+    }
+    print_results(out, jobs, job_count);
+    if (out != stdout)
+        fclose(out);
+
+    uint64_t total_cycles = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < job_count; i++) {
+        total_cycles += jobs[i].cycles_run;
+        failed += !jobs[i].ok;
+    }
+    fprintf(stderr, "%zu jobs (%zu failed) on %ld workers in %.3f s, %.2f MIPS aggregate, %" PRIu64 " steals\n",
+            job_count, failed, worker_count, elapsed / 1e9,
+            elapsed ? total_cycles / (elapsed / 1e3) : 0.0, steals);
+
+    for (size_t i = 0; i < job_count; i++)
+        free_job(&jobs[i]);
+    free(jobs);
+    free(items);
+    free(workers);
+    free(threads);
+    free(batch.deques);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "trace.h"
+
+/*
+    chip8-trace: decodes a binary trace written with `chip8_emulator --trace`
+    back into the human readable per-cycle format.
+*/
+
+static void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [options] <trace_file>\n", prog_name);
+    fprintf(stderr, "\nOptions:\n");
+    fprintf(stderr, "  -h, --help            Show this help message and exit\n");
+    fprintf(stderr, "  -s, --skip <count>    Skip the first <count> records\n");
+    fprintf(stderr, "  -n, --count <count>   Print at most <count> records\n");
+}
+
+int main(int argc, char *argv[]) {
+    long skip = 0;
+    long count = -1;
+
+    static struct option long_options[] = {
+        {"help",  no_argument,       0, 'h'},
+        {"skip",  required_argument, 0, 's'},
+        {"count", required_argument, 0, 'n'},
+        {0, 0, 0, 0}
+    };
+
+    int opt_char;
+    while ((opt_char = getopt_long(argc, argv, "hs:n:", long_options, NULL)) != -1) {
+        switch (opt_char) {
+            case 'h': print_usage(argv[0]); return 0;
+            case 's': skip = strtol(optarg, NULL, 10); break;
+            case 'n': count = strtol(optarg, NULL, 10); break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Error: Missing required trace file argument.\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(argv[optind], "rb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open trace file %s\n", argv[optind]);
+        return 1;
+    }
+
+    trace_file_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1
+        || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "Error: %s is not a CHIP-8 trace file\n", argv[optind]);
+        fclose(file);
+        return 1;
+    }
+    if (header.version != TRACE_VERSION || header.record_size != sizeof(trace_record_t)) {
+        fprintf(stderr, "Error: Unsupported trace version %u (record size %u)\n",
+                header.version, header.record_size);
+        fclose(file);
+        return 1;
+    }
+
+    if (skip > 0)
+        fseek(file, skip * (long)sizeof(trace_record_t), SEEK_CUR);
+
+    trace_record_t records[1024];
+    size_t read;
+    while (count != 0 && (read = fread(records, sizeof(trace_record_t), 1024, file)) > 0) {
+        for (size_t i = 0; i < read && count != 0; i++, count--)
+            trace_print_record(stdout, &records[i]);
+    }
+
+    fclose(file);
+    return 0;
+}